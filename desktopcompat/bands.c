@@ -0,0 +1,217 @@
+#include "bands.h"
+#include "drawlist.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define BANDS_MAX_THREADS 16
+#define BANDS_MAX 256
+#define BANDS_PER_THREAD 4
+#define BAND_MIN_HEIGHT 16
+
+// Each thread owns a range of band indices packed as lo << 32 | hi. The
+// owner takes bands from the front, idle threads steal from the back;
+// both sides update the range with a CAS.
+static struct {
+	pthread_mutex_t lock;
+	pthread_cond_t start;
+	pthread_cond_t done;
+	unsigned generation;
+	int pending;
+	bool quit;
+	int thread_count; // including the calling thread
+	pthread_t threads[BANDS_MAX_THREADS];
+	uint64_t ranges[BANDS_MAX_THREADS];
+
+	const DrawList* list;
+	GraphicsContext* ctx;
+	int band_height;
+	int band_count;
+	DamageList damage[BANDS_MAX];
+	int failures[BANDS_MAX];
+	vec2d scratch[BANDS_MAX_THREADS][DL_MAX_VERTICES]; // per thread
+} pool = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.start = PTHREAD_COND_INITIALIZER,
+	.done = PTHREAD_COND_INITIALIZER,
+};
+
+static uint64_t pack_range(uint32_t lo, uint32_t hi)
+{
+	return (uint64_t)lo << 32 | hi;
+}
+
+static int take_own(int id)
+{
+	uint64_t range = __atomic_load_n(&pool.ranges[id], __ATOMIC_ACQUIRE);
+	for (;;) {
+		uint32_t lo = range >> 32, hi = (uint32_t)range;
+		if (lo >= hi) return -1;
+		if (__atomic_compare_exchange_n(&pool.ranges[id], &range, pack_range(lo + 1, hi),
+		                                false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+			return lo;
+		}
+	}
+}
+
+static int steal(int id)
+{
+	for (int k = 1; k < pool.thread_count; k++) {
+		int victim = (id + k) % pool.thread_count;
+		uint64_t range = __atomic_load_n(&pool.ranges[victim], __ATOMIC_ACQUIRE);
+		for (;;) {
+			uint32_t lo = range >> 32, hi = (uint32_t)range;
+			if (lo >= hi) break;
+			if (__atomic_compare_exchange_n(&pool.ranges[victim], &range, pack_range(lo, hi - 1),
+			                                false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+				return hi - 1;
+			}
+		}
+	}
+	return -1;
+}
+
+static void render_band(int band, int id)
+{
+	GraphicsContext* ctx = pool.ctx;
+	int y0 = band * pool.band_height;
+	int y1 = y0 + pool.band_height < ctx->height ? y0 + pool.band_height : ctx->height;
+
+	GraphicsContext sub = {0};
+	sub.framebuf = ctx->framebuf + (size_t)y0 * ctx->width;
+	if (ctx->indexbuf) {
+		sub.indexbuf = ctx->indexbuf + (size_t)y0 * ctx->width;
+		sub.palette = ctx->palette;
+	}
+	sub.width = ctx->width;
+	sub.height = y1 - y0;
+	sub.track_damage = ctx->track_damage;
+
+	drawlist_execute_band(pool.list, &sub, y0, pool.scratch[id]);
+	pool.damage[band] = sub.damage;
+	pool.failures[band] = sub.failures;
+}
+
+static void run_bands(int id)
+{
+	int band;
+	while ((band = take_own(id)) >= 0 || (band = steal(id)) >= 0) {
+		render_band(band, id);
+	}
+}
+
+static void* worker_main(void* arg)
+{
+	int id = (int)(intptr_t)arg;
+	unsigned seen = 0;
+
+	for (;;) {
+		pthread_mutex_lock(&pool.lock);
+		while (pool.generation == seen && !pool.quit) {
+			pthread_cond_wait(&pool.start, &pool.lock);
+		}
+		if (pool.quit) {
+			pthread_mutex_unlock(&pool.lock);
+			return NULL;
+		}
+		seen = pool.generation;
+		pthread_mutex_unlock(&pool.lock);
+
+		run_bands(id);
+
+		pthread_mutex_lock(&pool.lock);
+		if (--pool.pending == 0) {
+			pthread_cond_signal(&pool.done);
+		}
+		pthread_mutex_unlock(&pool.lock);
+	}
+}
+
+static void bands_execute(DrawList* list, GraphicsContext* ctx)
+{
+	if (!ctx->framebuf || ctx->height < 2 * BAND_MIN_HEIGHT) {
+		drawlist_execute_serial(list, ctx);
+		return;
+	}
+
+	int band_height = ctx->height / (pool.thread_count * BANDS_PER_THREAD);
+	if (band_height < BAND_MIN_HEIGHT) band_height = BAND_MIN_HEIGHT;
+	int band_count = (ctx->height + band_height - 1) / band_height;
+	if (band_count > BANDS_MAX) {
+		band_count = BANDS_MAX;
+		band_height = (ctx->height + BANDS_MAX - 1) / BANDS_MAX;
+		band_count = (ctx->height + band_height - 1) / band_height;
+	}
+
+	drawlist_sort(list);
+	pool.list = list;
+	pool.ctx = ctx;
+	pool.band_height = band_height;
+	pool.band_count = band_count;
+	for (int i = 0; i < pool.thread_count; i++) {
+		pool.ranges[i] = pack_range(band_count * i / pool.thread_count, band_count * (i + 1) / pool.thread_count);
+	}
+
+	pthread_mutex_lock(&pool.lock);
+	pool.generation++;
+	pool.pending = pool.thread_count - 1;
+	pthread_cond_broadcast(&pool.start);
+	pthread_mutex_unlock(&pool.lock);
+
+	run_bands(0);
+
+	pthread_mutex_lock(&pool.lock);
+	while (pool.pending > 0) {
+		pthread_cond_wait(&pool.done, &pool.lock);
+	}
+	pthread_mutex_unlock(&pool.lock);
+
+	// merged in band order, so the result doesn't depend on scheduling
+	for (int band = 0; band < band_count; band++) {
+		int y0 = band * band_height;
+		ctx->failures += pool.failures[band];
+		for (int i = 0; i < pool.damage[band].count; i++) {
+			GfxRect r = pool.damage[band].rects[i];
+			add_damage(ctx, (GfxRect){r.x0, r.y0 + y0, r.x1, r.y1 + y0});
+		}
+	}
+}
+
+bool bands_init(int thread_count)
+{
+	if (thread_count > BANDS_MAX_THREADS) thread_count = BANDS_MAX_THREADS;
+	if (thread_count < 2) {
+		return false;
+	}
+
+	pool.quit = false;
+	pool.thread_count = 1;
+	for (int i = 1; i < thread_count; i++) {
+		if (pthread_create(&pool.threads[i], NULL, worker_main, (void*)(intptr_t)i) != 0) {
+			printf("bands: could not start worker %d\n", i);
+			break;
+		}
+		pool.thread_count++;
+	}
+	if (pool.thread_count < 2) {
+		return false;
+	}
+	drawlist_set_executor(bands_execute);
+	return true;
+}
+
+void bands_shutdown(void)
+{
+	if (pool.thread_count < 2) return;
+
+	drawlist_set_executor(NULL);
+	pthread_mutex_lock(&pool.lock);
+	pool.quit = true;
+	pthread_cond_broadcast(&pool.start);
+	pthread_mutex_unlock(&pool.lock);
+
+	for (int i = 1; i < pool.thread_count; i++) {
+		pthread_join(pool.threads[i], NULL);
+	}
+	pool.thread_count = 0;
+}
@@ -0,0 +1,11 @@
+#ifndef BANDS_H
+#define BANDS_H
+
+#include <stdbool.h>
+
+// Band-parallel rasterizer for the framebuffer path. bands_init() starts
+// the worker threads and installs itself as the draw list executor.
+bool bands_init(int thread_count);
+void bands_shutdown(void);
+
+#endif
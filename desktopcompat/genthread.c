@@ -0,0 +1,124 @@
+#include "genthread.h"
+#include "worldgen.h"
+#include <pthread.h>
+#include <limits.h>
+#include <stdio.h>
+
+// how far past what the generator asks for the thread keeps placing
+#define GENTHREAD_LEAD 20000
+
+static struct {
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_cond_t progress;
+	pthread_t thread;
+	bool running;
+	bool quit;
+	bool paused;
+	bool idle;
+	unsigned requests;
+	unsigned placed;
+	int target_x;
+	int detail;
+} gen = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.wake = PTHREAD_COND_INITIALIZER,
+	.progress = PTHREAD_COND_INITIALIZER,
+	.paused = true,
+	.idle = true,
+};
+
+static void* producer_main(void* arg)
+{
+	(void)arg;
+	unsigned seen = 0;
+	bool more = false;
+
+	pthread_mutex_lock(&gen.lock);
+	for (;;) {
+		// keeps placing until it can't, then sleeps until the next request
+		while (!gen.quit && (gen.paused || (!more && seen == gen.requests))) {
+			if (!gen.idle) {
+				gen.idle = true;
+				pthread_cond_broadcast(&gen.progress);
+			}
+			pthread_cond_wait(&gen.wake, &gen.lock);
+		}
+		if (gen.quit) break;
+		gen.idle = false;
+		seen = gen.requests;
+		int target_x = gen.target_x;
+		int detail = gen.detail;
+		pthread_mutex_unlock(&gen.lock);
+
+		more = worldgen_place_structure(target_x, detail);
+
+		pthread_mutex_lock(&gen.lock);
+		if (more) {
+			gen.placed++;
+			pthread_cond_broadcast(&gen.progress);
+		}
+	}
+	gen.idle = true;
+	pthread_cond_broadcast(&gen.progress);
+	pthread_mutex_unlock(&gen.lock);
+	return NULL;
+}
+
+static void thread_request(int target_x, int detail)
+{
+	pthread_mutex_lock(&gen.lock);
+	gen.target_x = target_x > INT_MAX - GENTHREAD_LEAD ? INT_MAX : target_x + GENTHREAD_LEAD;
+	gen.detail = detail;
+	gen.paused = false;
+	gen.idle = false;
+	gen.requests++;
+	pthread_cond_signal(&gen.wake);
+	pthread_mutex_unlock(&gen.lock);
+}
+
+static void thread_wait(void)
+{
+	pthread_mutex_lock(&gen.lock);
+	unsigned placed = gen.placed;
+	while (gen.placed == placed && !gen.idle) {
+		pthread_cond_wait(&gen.progress, &gen.lock);
+	}
+	pthread_mutex_unlock(&gen.lock);
+}
+
+static void thread_stop(void)
+{
+	pthread_mutex_lock(&gen.lock);
+	gen.paused = true;
+	pthread_cond_signal(&gen.wake);
+	while (!gen.idle) {
+		pthread_cond_wait(&gen.progress, &gen.lock);
+	}
+	pthread_mutex_unlock(&gen.lock);
+}
+
+static const WorldgenProducer thread_producer = {thread_request, thread_wait, thread_stop};
+
+bool genthread_init(void)
+{
+	if (pthread_create(&gen.thread, NULL, producer_main, NULL) != 0) {
+		printf("Generator thread failed, placing structures inline\n");
+		return false;
+	}
+	gen.running = true;
+	worldgen_set_producer(&thread_producer);
+	return true;
+}
+
+void genthread_shutdown(void)
+{
+	if (!gen.running) return;
+	worldgen_set_producer(NULL);
+	pthread_mutex_lock(&gen.lock);
+	gen.quit = true;
+	pthread_cond_signal(&gen.wake);
+	pthread_mutex_unlock(&gen.lock);
+	pthread_join(gen.thread, NULL);
+	gen.running = false;
+}
@@ -0,0 +1,11 @@
+#ifndef GENTHREAD_H
+#define GENTHREAD_H
+
+#include <stdbool.h>
+
+// Places upcoming structures on a thread of its own. genthread_init()
+// starts it and installs it as the world generator's producer.
+bool genthread_init(void);
+void genthread_shutdown(void);
+
+#endif
@@ -20,6 +20,38 @@ void clear(GraphicsContext* ctx) {
 	SDL_RenderClear(g_renderer);
 }
 
+void begin_frame(GraphicsContext* ctx) {
+	clear(ctx);
+}
+
+void keep_frame(GraphicsContext* ctx) {
+	(void)ctx;
+}
+
+void damage_reset(GraphicsContext* ctx) {
+	(void)ctx;
+}
+
+void add_damage(GraphicsContext* ctx, GfxRect rect) {
+	(void)ctx; (void)rect;
+}
+
+void expand_frame(GraphicsContext* ctx) {
+	(void)ctx;
+}
+
+int get_refresh_rects(const GraphicsContext* ctx, GfxRect* out, int max_count) {
+	if (max_count < 1) return 0;
+	out[0] = (GfxRect){0, 0, ctx->width, ctx->height};
+	return 1;
+}
+
+int refresh_display(GraphicsContext* back, const GraphicsContext* front, RefreshFn push) {
+	(void)front;
+	push(back, 0, back->height);
+	return back->height;
+}
+
 void fill(GraphicsContext* ctx, uint16_t color) {
 	(void)ctx;
 	uint8_t r, g, b, a;
@@ -35,7 +67,7 @@ void draw_pixel(GraphicsContext* ctx, int x, int y, uint16_t color) {
 	pixelRGBA(g_renderer, x, y, r, g, b, a);
 }
 
-void draw_line(GraphicsContext* ctx, int x0, int y0, int x1, int y1, float thickness, uint16_t color) {
+void draw_line_capped(GraphicsContext* ctx, int x0, int y0, int x1, int y1, int thickness, int cap, uint16_t color) {
 	(void)ctx;
 	if (thickness < 1) thickness = 1;
 
@@ -47,11 +79,35 @@ void draw_line(GraphicsContext* ctx, int x0, int y0, int x1, int y1, float thick
 		return;
 	}
 
+	if (cap == LINE_CAP_SQUARE) {
+		float dx = x1 - x0;
+		float dy = y1 - y0;
+		float len = sqrtf(dx * dx + dy * dy);
+		if (len > 0) {
+			int ex = dx * thickness / 2 / len;
+			int ey = dy * thickness / 2 / len;
+			x0 -= ex; y0 -= ey;
+			x1 += ex; y1 += ey;
+		}
+	}
+
 	thickLineRGBA(g_renderer, x0, y0, x1, y1, (uint8_t)thickness, r, g, b, a);
 
-	int radius = thickness / 2;
-	filledCircleRGBA(g_renderer, x0, y0, radius, r, g, b, a);
-	filledCircleRGBA(g_renderer, x1, y1, radius, r, g, b, a);
+	if (cap == LINE_CAP_ROUND) {
+		int radius = thickness / 2;
+		filledCircleRGBA(g_renderer, x0, y0, radius, r, g, b, a);
+		filledCircleRGBA(g_renderer, x1, y1, radius, r, g, b, a);
+	}
+}
+
+void draw_line(GraphicsContext* ctx, int x0, int y0, int x1, int y1, int thickness, uint16_t color) {
+	draw_line_capped(ctx, x0, y0, x1, y1, thickness, LINE_CAP_ROUND, color);
+}
+
+void draw_polyline(GraphicsContext* ctx, const vec2d* points, int count, int thickness, uint16_t color) {
+	for (int i = 1; i < count; i++) {
+		draw_line(ctx, points[i - 1].x, points[i - 1].y, points[i].x, points[i].y, thickness, color);
+	}
 }
 
 void draw_hline(GraphicsContext* ctx, int x1, int x2, int y, uint16_t color) {
@@ -68,7 +124,16 @@ void fill_rect(GraphicsContext* ctx, int x, int y, int w, int h, uint16_t color)
 	boxRGBA(g_renderer, x, y, x + w - 1, y + h - 1, r, g, b, a);
 }
 
-void draw_circle(GraphicsContext* ctx, int center_x, int center_y, int radius, float thickness, uint16_t color) {
+void draw_spans(GraphicsContext* ctx, const ColorSpan* spans, int count) {
+	(void)ctx;
+	for (int i = 0; i < count; i++) {
+		uint8_t r, g, b, a;
+		ColorFrom565(spans[i].color, &r, &g, &b, &a);
+		hlineRGBA(g_renderer, spans[i].x, spans[i].x + spans[i].len - 1, spans[i].y, r, g, b, a);
+	}
+}
+
+void draw_circle(GraphicsContext* ctx, int center_x, int center_y, int radius, int thickness, uint16_t color) {
 	(void)ctx;
 	if (radius <= 0 || thickness < 1) return;
 
@@ -104,7 +169,7 @@ void draw_solid_circle(GraphicsContext* ctx, int center_x, int center_y, int rad
 	filledCircleRGBA(g_renderer, center_x, center_y, radius, r, g, b, a);
 }
 
-void draw_polygon(GraphicsContext* ctx, const vec2d* vertices, int vertexCount, float thickness, uint16_t color) {
+void draw_polygon(GraphicsContext* ctx, const vec2d* vertices, int vertexCount, int thickness, uint16_t color) {
 	(void)ctx;
 
 	if (vertexCount < 2) {
@@ -138,6 +203,19 @@ void fill_polygon(GraphicsContext* ctx, const vec2d* vertices, int vertexCount,
 	free(vy);
 }
 
+void fill_columns(GraphicsContext* ctx, int x, const int16_t* tops, int count, uint16_t color) {
+	uint8_t r, g, b, a;
+	ColorFrom565(color, &r, &g, &b, &a);
+	// columns sharing a top go out as one box
+	for (int i = 0; i < count; ) {
+		int start = i++;
+		while (i < count && tops[i] == tops[start]) i++;
+		if (tops[start] < ctx->height) {
+			boxRGBA(g_renderer, x + start, tops[start], x + i - 1, ctx->height - 1, r, g, b, a);
+		}
+	}
+}
+
 void draw_text(GraphicsContext* ctx, const char* text, int x, int y, uint16_t color, int anchor) {
 	(void)ctx;
 	const int char_w = 8;
@@ -1,9 +1,15 @@
 #include <SDL2/SDL.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 #include "graphics.h"
 #include "game.h"
+#include "scheduler.h"
 #include "compat.h"
+#include "genthread.h"
+#include "worldgen.h"
+#include "replay.h"
 #include <SDL2/SDL_render.h>
 #include <SDL2/SDL_events.h>
 #include <SDL2/SDL.h>
@@ -11,31 +17,94 @@
 SDL_Window* g_window = NULL;
 SDL_Renderer* g_renderer = NULL;
 
-GraphicsContext screen_context;
+static GraphicsContext screen_context;
+
+#ifdef SW_RENDERER
+#include "bands.h"
+
+static SDL_Texture* g_screen_texture = NULL;
+
+// (Re)creates the RGB565 framebuffer and its streaming texture when the
+// output size changes.
+static bool framebuf_resize(int w, int h)
+{
+	if (g_screen_texture && screen_context.width == w && screen_context.height == h) {
+		return true;
+	}
+
+	if (g_screen_texture) {
+		SDL_DestroyTexture(g_screen_texture);
+	}
+	free(screen_context.framebuf);
+
+	screen_context.framebuf = malloc((size_t)w * h * sizeof(uint16_t));
+	g_screen_texture = SDL_CreateTexture(g_renderer, SDL_PIXELFORMAT_RGB565, SDL_TEXTUREACCESS_STREAMING, w, h);
+	if (!screen_context.framebuf || !g_screen_texture) {
+		fprintf(stderr, "Could not create framebuffer: %s\n", SDL_GetError());
+		return false;
+	}
+	screen_context.width = w;
+	screen_context.height = h;
+	screen_context.track_damage = true;
+	damage_reset(&screen_context);
+	return true;
+}
+
+static void texture_push(GraphicsContext* ctx, int y0, int y1)
+{
+	int pitch = ctx->width * sizeof(uint16_t);
+	SDL_Rect rows = {0, y0, ctx->width, y1 - y0};
+	SDL_UpdateTexture(g_screen_texture, &rows, ctx->framebuf + y0 * ctx->width, pitch);
+}
+
+// Uploads the rows that changed since the last frame, then shows the texture.
+static void framebuf_present(void)
+{
+	refresh_display(&screen_context, &screen_context, texture_push);
+	SDL_RenderCopy(g_renderer, g_screen_texture, NULL, NULL);
+}
+#endif
 
 void handle_key_event(SDL_KeyboardEvent* key) {
 	switch(key->keysym.scancode) {
 		case SDL_SCANCODE_R:
-			if (key->type == SDL_KEYDOWN && key->repeat == 0) game_init();
+			if (key->type == SDL_KEYDOWN && key->repeat == 0) replay_input(INPUT_RESTART);
 			break;
 		case SDL_SCANCODE_ESCAPE:
 			if (key->type == SDL_KEYDOWN && key->repeat == 0) g_is_paused = !g_is_paused;
 			break;
+		case SDL_SCANCODE_5:
+			if (key->type == SDL_KEYDOWN && key->repeat == 0) g_fill_ground = !g_fill_ground;
+			break;
 		case SDL_SCANCODE_4:
 			if (key->type == SDL_KEYDOWN && key->repeat == 0) game_print_debug();
 			break;
 		default:
 			if (key->type == SDL_KEYDOWN && key->repeat == 0) {
-				game_handle_keydown_default();
+				replay_input(INPUT_GAS_DOWN);
 			} else if (key->type == SDL_KEYUP) {
-				game_handle_keyup_default();
+				replay_input(INPUT_GAS_UP);
 			}
 			break;
 	}
 }
 
+// app [--seed S] [--record FILE | --play FILE]
 int main(int argc, char* argv[]) {
-	(void)argc; (void)argv;
+	uint32_t seed = 1;
+	const char* record_path = NULL;
+	const char* play_path = NULL;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if (!strcmp(argv[i], "--seed")) {
+			seed = strtoul(argv[i + 1], NULL, 0);
+		} else if (!strcmp(argv[i], "--record")) {
+			record_path = argv[i + 1];
+		} else if (!strcmp(argv[i], "--play")) {
+			play_path = argv[i + 1];
+		} else {
+			break;
+		}
+	}
 
 	if (SDL_Init(SDL_INIT_VIDEO) < 0) {
 		fprintf(stderr, "Could not initialize SDL: %s\n", SDL_GetError());
@@ -60,7 +129,22 @@ int main(int argc, char* argv[]) {
 		return 1;
 	}
 
+#ifdef SW_RENDERER
+	bands_init(SDL_GetCPUCount());
+#endif
+	genthread_init();
+
+	int step_ms = PHYSICS_STEP_MS;
+	worldgen_seed(seed);
+	if (play_path && replay_play(play_path)) {
+		step_ms = replay_step_ms();
+	} else if (record_path) {
+		replay_record(step_ms);
+	}
+
 	uint32_t last_time = sys_timer_ms();
+	Scheduler scheduler;
+	scheduler_init(&scheduler, step_ms, MAX_STEPS_PER_FRAME, MAX_FRAME_SKIP);
 	game_init();
 
 	bool running = true;
@@ -79,21 +163,54 @@ int main(int argc, char* argv[]) {
 			}
 		}
 
+#ifdef SW_RENDERER
+		int output_w, output_h;
+		SDL_GetRendererOutputSize(g_renderer, &output_w, &output_h);
+		if (!framebuf_resize(output_w, output_h)) {
+			break;
+		}
+#else
 		SDL_GetRendererOutputSize(g_renderer, &screen_context.width, &screen_context.height);
 		screen_context.framebuf = NULL;
+#endif
 
 		uint32_t current_time = sys_timer_ms();
 		uint32_t delta_ms = current_time - last_time;
 		last_time = current_time;
 		if (delta_ms > 250) delta_ms = 250;
-		if (!g_is_paused) game_update(delta_ms);
+		bool draw = scheduler_run(&scheduler, g_is_paused ? 0 : delta_ms, replay_step);
+		if (replay_finished()) {
+			// the keyboard takes over from here
+			printf("Replay finished after %u ticks\n", (unsigned)replay_ticks());
+			replay_stop();
+		}
+		if (!draw) {
+			continue;
+		}
+		game_set_render_alpha(scheduler_alpha(&scheduler));
 
+#ifdef SW_RENDERER
+		game_draw(&screen_context);
+		framebuf_present();
+#else
 		clear(&screen_context);
 		game_draw(&screen_context);
+#endif
 		SDL_RenderPresent(g_renderer);
 	}
 
+	if (record_path && replay_mode() == REPLAY_RECORDING) {
+		replay_save(record_path);
+	}
 	game_destroy();
+	genthread_shutdown();
+#ifdef SW_RENDERER
+	bands_shutdown();
+	if (g_screen_texture) {
+		SDL_DestroyTexture(g_screen_texture);
+	}
+	free(screen_context.framebuf);
+#endif
 	SDL_DestroyRenderer(g_renderer);
 	SDL_DestroyWindow(g_window);
 	SDL_Quit();
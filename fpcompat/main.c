@@ -8,9 +8,36 @@
 
 #include "graphics.h"
 #include "game.h"
+#include "scheduler.h"
 #include "compat.h"
 
-GraphicsContext screen_context;
+// 2: draw the next frame while the LCD is still reading the previous one,
+// 1: single buffer, drawing waits for the transfer to finish
+#ifndef FRAMEBUF_COUNT
+#define FRAMEBUF_COUNT 2
+#endif
+
+// 1: draw palette indices into an 8-bit buffer, which halves the fill
+// bandwidth, and expand what changed into the RGB565 buffer the LCD reads
+// just before each refresh. Drawing then overlaps the refresh with one
+// buffer of each kind: 3 bytes per pixel, against 4 for FRAMEBUF_COUNT 2
+// and 2 for a single RGB565 buffer. It can't get below that, since the
+// fpdoom refresh reads the whole frame from the one buffer given to
+// sys_framebuffer() and takes no strips to expand into.
+#ifndef INDEXED_FRAMEBUF
+#define INDEXED_FRAMEBUF 0
+#endif
+
+#if INDEXED_FRAMEBUF
+#undef FRAMEBUF_COUNT
+#define FRAMEBUF_COUNT 1
+static Palette palette;
+#endif
+
+static GraphicsContext frames[FRAMEBUF_COUNT];
+static GraphicsContext* front; // being shown or transferred
+static GraphicsContext* back;  // being drawn
+static bool refresh_pending;
 
 static void *framebuf_mem = NULL;
 
@@ -31,6 +58,7 @@ int handle_events(void)
 			case KEY_LSOFT: game_init(); break;
 			case KEY_RSOFT: g_is_paused = !g_is_paused; break;
 			case KEY_STAR: case KEY_PLUS: return 1;
+			case KEY_5: g_fill_ground = !g_fill_ground; break;
 			case KEY_4: game_print_debug();
 			default:
 				game_handle_keydown_default();
@@ -54,13 +82,66 @@ void lcd_appinit(void)
 static void framebuf_alloc(void)
 {
 	struct sys_display *disp = &sys_data.display;
-	size_t size = disp->w1 * disp->h1;
+	size_t size = (disp->w1 * disp->h1 * 2 + 31) & ~31;
+	size_t index_size = INDEXED_FRAMEBUF ? (disp->w1 * disp->h1 + 31) & ~31 : 0;
 	uint8_t *p;
-	framebuf_mem = p = malloc(size * 2 + 31);
+	framebuf_mem = p = malloc((size + index_size) * FRAMEBUF_COUNT + 31);
 	p += -(intptr_t)p & 31;
-	screen_context.framebuf = (void*)p;
-	screen_context.width = disp->w1;
-	screen_context.height = disp->h1;
+#if INDEXED_FRAMEBUF
+	palette_init(&palette);
+#endif
+	for (int i = 0; i < FRAMEBUF_COUNT; i++) {
+		GraphicsContext* ctx = &frames[i];
+		ctx->framebuf = (void*)(p + size * i);
+#if INDEXED_FRAMEBUF
+		ctx->indexbuf = p + size * FRAMEBUF_COUNT + index_size * i;
+		ctx->palette = &palette;
+#endif
+		ctx->width = disp->w1;
+		ctx->height = disp->h1;
+		ctx->track_damage = true;
+		damage_reset(ctx);
+	}
+	front = &frames[0];
+	back = &frames[FRAMEBUF_COUNT - 1];
+}
+
+// Called before drawing: with a single buffer the frame can't be touched
+// while the LCD is reading it. An indexed frame is drawn apart from it.
+static void lcd_wait_for_back(void)
+{
+	if (refresh_pending && back == front && !back->indexbuf) {
+		sys_wait_refresh();
+		refresh_pending = false;
+	}
+}
+
+// The fpdoom refresh has no window, so any band costs a whole frame: only
+// frames with nothing changed are saved. Only here do we wait for the
+// previous transfer.
+static void lcd_push(GraphicsContext* ctx, int y0, int y1)
+{
+	(void)y0; (void)y1;
+	if (refresh_pending) {
+		sys_wait_refresh();
+	}
+	expand_frame(ctx);
+	sys_framebuffer(ctx->framebuf);
+	sys_start_refresh();
+	refresh_pending = true;
+}
+
+// Starts pushing the frame just drawn to the LCD unless it shows nothing
+// new, and makes the other buffer the back one.
+static void lcd_present(void)
+{
+	if (refresh_display(back, front, lcd_push) == 0) {
+		return;
+	}
+
+	GraphicsContext* shown = back;
+	back = front;
+	front = shown;
 }
 
 int main(int argc, char **argv)
@@ -68,12 +149,14 @@ int main(int argc, char **argv)
 	(void)argc; (void)argv;
 	b2SetAllocator(custom_aligned_alloc, custom_aligned_free);
 	framebuf_alloc();
-	sys_framebuffer(screen_context.framebuf);
+	sys_framebuffer(front->framebuf);
 	sys_start();
 
 	uint32_t last_time = sys_timer_ms();
 	uint32_t last_sleep_time = sys_timer_ms();
 
+	Scheduler scheduler;
+	scheduler_init(&scheduler, PHYSICS_STEP_MS, MAX_STEPS_PER_FRAME, MAX_FRAME_SKIP);
 	game_init();
 
 	while (1) {
@@ -87,15 +170,13 @@ int main(int argc, char **argv)
 			last_tick_ms = 250;
 		}
 
-		if (!g_is_paused) {
-			game_update(last_tick_ms);
+		if (scheduler_run(&scheduler, g_is_paused ? 0 : last_tick_ms, game_update)) {
+			game_set_render_alpha(scheduler_alpha(&scheduler));
+			lcd_wait_for_back();
+			game_draw(back);
+			lcd_present();
 		}
 
-		game_draw(&screen_context);
-
-		sys_start_refresh();
-		sys_wait_refresh();
-
 		int32_t elapsed = sys_timer_ms() - last_sleep_time;
 		if (elapsed < 0) elapsed = 0;
 
@@ -105,6 +186,9 @@ int main(int argc, char **argv)
 		}
 		last_sleep_time = sys_timer_ms();
 	}
+	if (refresh_pending) {
+		sys_wait_refresh();
+	}
 	game_destroy();
 
 	free(framebuf_mem);
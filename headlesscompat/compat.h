@@ -0,0 +1,14 @@
+#include <stdint.h>
+
+#ifndef COMPAT_H
+#define COMPAT_H
+
+// Simulated clock: advanced by the headless loop by the fixed dt, so game
+// logic that reads the time behaves the same on every run.
+extern uint32_t headless_time_ms;
+
+static inline uint32_t sys_timer_ms(void) {
+	return headless_time_ms;
+}
+
+#endif
@@ -0,0 +1,69 @@
+#include "lcd_sim.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static struct {
+	int transfer_ms;
+	size_t size;
+	const uint16_t* source;
+	uint16_t* shown;
+	pthread_t thread;
+	bool running;
+} lcd;
+
+static void* transfer_main(void* arg)
+{
+	(void)arg;
+	struct timespec ts = {lcd.transfer_ms / 1000, lcd.transfer_ms % 1000 * 1000000L};
+	nanosleep(&ts, NULL);
+	memcpy(lcd.shown, lcd.source, lcd.size);
+	return NULL;
+}
+
+void lcd_sim_init(int transfer_ms, int width, int height)
+{
+	lcd.transfer_ms = transfer_ms;
+	lcd.size = (size_t)width * height * sizeof(uint16_t);
+	lcd.shown = calloc(1, lcd.size);
+	lcd.running = false;
+}
+
+void lcd_sim_start(const uint16_t* framebuf)
+{
+	lcd_sim_wait();
+	lcd.source = framebuf;
+	if (lcd.transfer_ms <= 0 || pthread_create(&lcd.thread, NULL, transfer_main, NULL) != 0) {
+		if (lcd.shown) memcpy(lcd.shown, framebuf, lcd.size);
+		return;
+	}
+	lcd.running = true;
+}
+
+void lcd_sim_wait(void)
+{
+	if (lcd.running) {
+		pthread_join(lcd.thread, NULL);
+		lcd.running = false;
+	}
+}
+
+// True while a transfer is reading `framebuf`; drawing into it then tears.
+bool lcd_sim_busy_with(const uint16_t* framebuf)
+{
+	return lcd.running && lcd.source == framebuf;
+}
+
+const uint16_t* lcd_sim_shown(void)
+{
+	return lcd.shown;
+}
+
+void lcd_sim_free(void)
+{
+	lcd_sim_wait();
+	free(lcd.shown);
+	lcd.shown = NULL;
+}
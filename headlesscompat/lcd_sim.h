@@ -0,0 +1,17 @@
+#ifndef LCD_SIM_H
+#define LCD_SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Stand-in for the device's asynchronous LCD refresh: a transfer reads the
+// framebuffer for `transfer_ms` of wall time on a separate thread, then
+// the frame is considered shown.
+void lcd_sim_init(int transfer_ms, int width, int height);
+void lcd_sim_start(const uint16_t* framebuf);
+void lcd_sim_wait(void);
+bool lcd_sim_busy_with(const uint16_t* framebuf);
+const uint16_t* lcd_sim_shown(void);
+void lcd_sim_free(void);
+
+#endif
@@ -0,0 +1,522 @@
+// Headless runner: plays the game with a fixed dt and seed into an
+// in-memory framebuffer, dumps selected frames as PPM, compares them
+// against golden images and reports per-frame timings.
+//
+//   app-headless [--frames N] [--dt MS] [--step MS] [--seed S] [--size WxH] [--gas]
+//                [--dump F1,F2,...] [--dump-every N] [--out DIR]
+//                [--golden DIR] [--tolerance T] [--max-bad N]
+//                [--timing FILE] [--replay N] [--buffers 1|2] [--lcd-ms MS]
+//                [--indexed] [--fill-ground] [--record FILE] [--play FILE]
+//                [--restart F1,F2,...] [--scene]
+//
+// Golden images are frames previously dumped with the same options;
+// a frame fails when more than --max-bad pixels differ by more than
+// --tolerance in any channel. --replay rasterizes the last frame's draw
+// list N more times to time the backend alone.
+//
+// Frames are presented like on the device: with --buffers 2 the next
+// frame is drawn while the previous one is transferred, and --lcd-ms makes
+// each transfer take that much wall time on another thread. Drawing into a
+// buffer that is still being transferred counts as a tear. Exit status is
+// non-zero on any failure.
+//
+// Each frame of --dt ms goes through the same fixed-step scheduler as the
+// device, stepping the game --step ms at a time. Frames it skips are not
+// drawn, dumped or compared.
+//
+// --indexed draws palette indices into 8-bit buffers and expands each
+// frame to RGB565 before presenting it, like INDEXED_FRAMEBUF on the device.
+//
+// --record saves the inputs of the run per tick along with its seed, step
+// and quality tier; --play runs a recording from the desktop build or
+// this one with exactly the same inputs, in place of --seed, --step,
+// --gas and --restart. --restart restarts the game before the given
+// frames, as the restart key would, and with --gas presses it again.
+//
+// --scene draws the fixed test scene of scene.c in place of the game. Its
+// frames don't depend on Box2D or the font, which is what lets
+// tests/golden hold checked-in references for it. Timings are reported
+// and written out, never compared.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "graphics.h"
+#include "game.h"
+#include "scheduler.h"
+#include "compat.h"
+#include "worldgen.h"
+#include "replay.h"
+#include "lcd_sim.h"
+#include "scene.h"
+
+#define MAX_DUMP_FRAMES 64
+#define MAX_RESTART_FRAMES 16
+
+uint32_t headless_time_ms;
+
+typedef struct {
+	int frames;
+	int dt;
+	int step;
+	unsigned seed;
+	int width;
+	int height;
+	int gas;
+	int dump[MAX_DUMP_FRAMES];
+	int dump_count;
+	int dump_every;
+	const char* out_dir;
+	const char* golden_dir;
+	int tolerance;
+	long max_bad;
+	const char* timing_path;
+	int replay;
+	int buffers;
+	int lcd_ms;
+	int indexed;
+	int fill_ground;
+	const char* record_path;
+	const char* play_path;
+	int restart[MAX_RESTART_FRAMES];
+	int restart_count;
+	int scene;
+} Options;
+
+typedef struct {
+	uint32_t update_us;
+	uint32_t render_us;
+	uint32_t frame_us;
+	int lcd_rows;
+	int steps;
+} FrameTiming;
+
+static uint64_t now_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void usage(const char* name)
+{
+	fprintf(stderr,
+		"usage: %s [--frames N] [--dt MS] [--step MS] [--seed S] [--size WxH] [--gas]\n"
+		"          [--dump F1,F2,...] [--dump-every N] [--out DIR]\n"
+		"          [--golden DIR] [--tolerance T] [--max-bad N] [--timing FILE]\n"
+		"          [--replay N] [--buffers 1|2] [--lcd-ms MS] [--indexed]\n"
+		"          [--fill-ground] [--record FILE] [--play FILE]\n"
+		"          [--restart F1,F2,...] [--scene]\n", name);
+}
+
+// comma separated frame numbers
+static int parse_frames(const char* val, int* frames, int max)
+{
+	int count = 0;
+	for (const char* p = val; *p && count < max; ) {
+		frames[count++] = atoi(p);
+		p = strchr(p, ',');
+		if (!p) break;
+		p++;
+	}
+	return count;
+}
+
+static int parse_options(int argc, char** argv, Options* opt)
+{
+	for (int i = 1; i < argc; i++) {
+		const char* arg = argv[i];
+		const char* val = i + 1 < argc ? argv[i + 1] : NULL;
+
+		if (!strcmp(arg, "--gas")) {
+			opt->gas = 1;
+			continue;
+		}
+		if (!strcmp(arg, "--indexed")) {
+			opt->indexed = 1;
+			continue;
+		}
+		if (!strcmp(arg, "--fill-ground")) {
+			opt->fill_ground = 1;
+			continue;
+		}
+		if (!strcmp(arg, "--scene")) {
+			opt->scene = 1;
+			continue;
+		}
+		if (!val) {
+			return -1;
+		}
+		i++;
+
+		if (!strcmp(arg, "--frames")) {
+			opt->frames = atoi(val);
+		} else if (!strcmp(arg, "--dt")) {
+			opt->dt = atoi(val);
+		} else if (!strcmp(arg, "--step")) {
+			opt->step = atoi(val);
+		} else if (!strcmp(arg, "--seed")) {
+			opt->seed = strtoul(val, NULL, 0);
+		} else if (!strcmp(arg, "--size")) {
+			if (sscanf(val, "%dx%d", &opt->width, &opt->height) != 2) return -1;
+		} else if (!strcmp(arg, "--dump")) {
+			opt->dump_count = parse_frames(val, opt->dump, MAX_DUMP_FRAMES);
+		} else if (!strcmp(arg, "--restart")) {
+			opt->restart_count = parse_frames(val, opt->restart, MAX_RESTART_FRAMES);
+		} else if (!strcmp(arg, "--dump-every")) {
+			opt->dump_every = atoi(val);
+		} else if (!strcmp(arg, "--out")) {
+			opt->out_dir = val;
+		} else if (!strcmp(arg, "--golden")) {
+			opt->golden_dir = val;
+		} else if (!strcmp(arg, "--tolerance")) {
+			opt->tolerance = atoi(val);
+		} else if (!strcmp(arg, "--max-bad")) {
+			opt->max_bad = atol(val);
+		} else if (!strcmp(arg, "--timing")) {
+			opt->timing_path = val;
+		} else if (!strcmp(arg, "--replay")) {
+			opt->replay = atoi(val);
+		} else if (!strcmp(arg, "--buffers")) {
+			opt->buffers = atoi(val);
+		} else if (!strcmp(arg, "--lcd-ms")) {
+			opt->lcd_ms = atoi(val);
+		} else if (!strcmp(arg, "--record")) {
+			opt->record_path = val;
+		} else if (!strcmp(arg, "--play")) {
+			opt->play_path = val;
+		} else {
+			return -1;
+		}
+	}
+	if (opt->frames <= 0 || opt->dt <= 0 || opt->step <= 0 || opt->width <= 0 || opt->height <= 0 ||
+	    opt->buffers < 1 || opt->buffers > 2) {
+		return -1;
+	}
+	return 0;
+}
+
+static int in_frames(const int* frames, int count, int frame)
+{
+	for (int i = 0; i < count; i++) {
+		if (frames[i] == frame) return 1;
+	}
+	return 0;
+}
+
+static int is_dump_frame(const Options* opt, int frame)
+{
+	if (opt->dump_every > 0 && frame % opt->dump_every == 0) {
+		return 1;
+	}
+	return in_frames(opt->dump, opt->dump_count, frame);
+}
+
+static void to_rgb888(const GraphicsContext* ctx, uint8_t* rgb)
+{
+	for (int i = 0; i < ctx->width * ctx->height; i++) {
+		uint16_t c = ctx->framebuf[i];
+		uint8_t r = c >> 11, g = c >> 5 & 0x3f, b = c & 0x1f;
+		*rgb++ = r << 3 | r >> 2;
+		*rgb++ = g << 2 | g >> 4;
+		*rgb++ = b << 3 | b >> 2;
+	}
+}
+
+static int write_ppm(const char* path, const uint8_t* rgb, int w, int h)
+{
+	FILE* f = fopen(path, "wb");
+	if (!f) {
+		fprintf(stderr, "cannot write %s\n", path);
+		return -1;
+	}
+	fprintf(f, "P6\n%d %d\n255\n", w, h);
+	size_t size = (size_t)w * h * 3;
+	int ok = fwrite(rgb, 1, size, f) == size;
+	fclose(f);
+	return ok ? 0 : -1;
+}
+
+static uint8_t* read_ppm(const char* path, int w, int h)
+{
+	FILE* f = fopen(path, "rb");
+	if (!f) {
+		return NULL;
+	}
+	int fw, fh, maxval;
+	uint8_t* rgb = NULL;
+	if (fscanf(f, "P6 %d %d %d", &fw, &fh, &maxval) == 3 && fw == w && fh == h && maxval == 255 && fgetc(f) != EOF) {
+		size_t size = (size_t)w * h * 3;
+		rgb = malloc(size);
+		if (rgb && fread(rgb, 1, size, f) != size) {
+			free(rgb);
+			rgb = NULL;
+		}
+	}
+	fclose(f);
+	return rgb;
+}
+
+// Returns the number of pixels that differ by more than `tolerance` in a channel.
+static long compare_rgb(const uint8_t* a, const uint8_t* b, int pixels, int tolerance)
+{
+	long bad = 0;
+	for (int i = 0; i < pixels; i++, a += 3, b += 3) {
+		for (int c = 0; c < 3; c++) {
+			if (abs(a[c] - b[c]) > tolerance) {
+				bad++;
+				break;
+			}
+		}
+	}
+	return bad;
+}
+
+static void scene_step(int dt)
+{
+	(void)dt;
+}
+
+// Like the device, transfers the whole frame whatever the band. Waits for
+// the previous transfer only now, just before the swap.
+static void lcd_push(GraphicsContext* ctx, int y0, int y1)
+{
+	(void)y0; (void)y1;
+	lcd_sim_start(ctx->framebuf);
+}
+
+static int compare_u32(const void* a, const void* b)
+{
+	uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+	return x < y ? -1 : x > y;
+}
+
+static void print_timing_summary(const char* name, const uint32_t* values, int count)
+{
+	uint32_t* sorted = malloc(count * sizeof(uint32_t));
+	if (!sorted) return;
+	memcpy(sorted, values, count * sizeof(uint32_t));
+	qsort(sorted, count, sizeof(uint32_t), compare_u32);
+
+	uint64_t sum = 0;
+	for (int i = 0; i < count; i++) sum += sorted[i];
+	printf("%s us: mean %llu, median %u, p95 %u, max %u\n", name,
+		(unsigned long long)(sum / count), sorted[count / 2], sorted[count * 95 / 100], sorted[count - 1]);
+	free(sorted);
+}
+
+int main(int argc, char** argv)
+{
+	Options opt = {
+		.frames = 600,
+		.dt = 16,
+		.step = PHYSICS_STEP_MS,
+		.seed = 1,
+		.width = 240,
+		.height = 320,
+		.out_dir = ".",
+		.buffers = 2,
+	};
+	if (parse_options(argc, argv, &opt)) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	GraphicsContext frames[2] = {0};
+	Palette palette;
+	palette_init(&palette);
+	for (int i = 0; i < opt.buffers; i++) {
+		frames[i].width = opt.width;
+		frames[i].height = opt.height;
+		frames[i].framebuf = malloc((size_t)opt.width * opt.height * sizeof(uint16_t));
+		if (opt.indexed) {
+			frames[i].indexbuf = malloc((size_t)opt.width * opt.height);
+			frames[i].palette = &palette;
+		}
+		if (!frames[i].framebuf || (opt.indexed && !frames[i].indexbuf)) {
+			fprintf(stderr, "out of memory\n");
+			return 1;
+		}
+		frames[i].track_damage = true;
+		damage_reset(&frames[i]);
+	}
+	GraphicsContext* front = &frames[0];
+	GraphicsContext* back = &frames[opt.buffers - 1];
+	uint8_t* rgb = malloc((size_t)opt.width * opt.height * 3);
+	FrameTiming* timings = calloc(opt.frames, sizeof(FrameTiming));
+	if (!rgb || !timings) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	lcd_sim_init(opt.lcd_ms, opt.width, opt.height);
+
+	worldgen_seed(opt.seed);
+	if (opt.play_path) {
+		if (!replay_play(opt.play_path)) return 1;
+		opt.step = replay_step_ms();
+	} else if (opt.record_path) {
+		replay_record(opt.step);
+	}
+	Scheduler scheduler;
+	scheduler_init(&scheduler, opt.step, MAX_STEPS_PER_FRAME, MAX_FRAME_SKIP);
+	headless_time_ms = 0;
+	if (opt.scene) {
+		scene_init(opt.seed);
+	} else {
+		game_init();
+		g_fill_ground = opt.fill_ground;
+		if (opt.gas) {
+			replay_input(INPUT_GAS_DOWN);
+		}
+	}
+
+	int failures = 0;
+	int tears = 0;
+	uint64_t run_start = now_us();
+	for (int frame = 0; frame < opt.frames; frame++) {
+		if (in_frames(opt.restart, opt.restart_count, frame)) {
+			replay_input(INPUT_RESTART);
+			if (opt.gas) {
+				replay_input(INPUT_GAS_DOWN);
+			}
+		}
+		uint64_t t0 = now_us();
+		bool draw = scheduler_run(&scheduler, opt.dt, opt.scene ? scene_step : replay_step);
+		uint64_t t1 = now_us();
+		timings[frame].update_us = t1 - t0;
+		timings[frame].steps = scheduler.steps;
+		if (!draw) {
+			headless_time_ms += opt.dt;
+			timings[frame].frame_us = t1 - t0;
+			continue;
+		}
+		if (!opt.scene) {
+			game_set_render_alpha(scheduler_alpha(&scheduler));
+		}
+
+		if (back == front) {
+			lcd_sim_wait();
+		}
+		if (lcd_sim_busy_with(back->framebuf)) {
+			tears++;
+		}
+		uint64_t t_draw = now_us();
+		if (opt.scene) {
+			scene_draw(back, headless_time_ms);
+		} else {
+			game_draw(back);
+		}
+		expand_frame(back);
+		uint64_t t2 = now_us();
+		headless_time_ms += opt.dt;
+
+		timings[frame].render_us = t2 - t_draw;
+		// the rows a windowed push would transfer
+		timings[frame].lcd_rows = refresh_display(back, front, lcd_push);
+
+		GraphicsContext* drawn = back;
+		if (timings[frame].lcd_rows > 0) {
+			back = front;
+			front = drawn;
+		}
+		timings[frame].frame_us = now_us() - t0;
+
+		if (!is_dump_frame(&opt, frame)) {
+			continue;
+		}
+
+		char path[512];
+		to_rgb888(drawn, rgb);
+		snprintf(path, sizeof(path), "%s/frame_%05d.ppm", opt.out_dir, frame);
+		if (write_ppm(path, rgb, opt.width, opt.height)) {
+			failures++;
+		}
+
+		if (opt.golden_dir) {
+			snprintf(path, sizeof(path), "%s/frame_%05d.ppm", opt.golden_dir, frame);
+			uint8_t* golden = read_ppm(path, opt.width, opt.height);
+			if (!golden) {
+				printf("frame %d: no golden image %s\n", frame, path);
+				failures++;
+				continue;
+			}
+			long bad = compare_rgb(rgb, golden, opt.width * opt.height, opt.tolerance);
+			printf("frame %d: %ld pixels differ\n", frame, bad);
+			if (bad > opt.max_bad) {
+				failures++;
+			}
+			free(golden);
+		}
+	}
+
+	uint32_t* values = malloc(opt.frames * sizeof(uint32_t));
+	if (values) {
+		for (int i = 0; i < opt.frames; i++) values[i] = timings[i].update_us;
+		print_timing_summary("update", values, opt.frames);
+		for (int i = 0; i < opt.frames; i++) values[i] = timings[i].render_us;
+		print_timing_summary("render", values, opt.frames);
+		for (int i = 0; i < opt.frames; i++) values[i] = timings[i].frame_us;
+		print_timing_summary("frame", values, opt.frames);
+		free(values);
+	}
+	lcd_sim_wait();
+	printf("wall ms: %llu for %d frames, %d buffer(s), lcd %d ms\n",
+		(unsigned long long)(now_us() - run_start) / 1000, opt.frames, opt.buffers, opt.lcd_ms);
+	if (tears) {
+		printf("%d frame(s) drawn into a buffer under transfer\n", tears);
+		failures++;
+	}
+	if (scheduler.skipped_total || scheduler.dropped_ms) {
+		printf("%d frame(s) skipped, %d ms of game time dropped\n", scheduler.skipped_total, scheduler.dropped_ms);
+	}
+	if (opt.play_path && !replay_finished()) {
+		printf("stopped before the end of the recording, %u ticks\n", (unsigned)replay_ticks());
+	}
+	if (opt.record_path && !opt.play_path && !replay_save(opt.record_path)) {
+		failures++;
+	}
+
+	if (opt.replay > 0) {
+		uint64_t t0 = now_us();
+		for (int i = 0; i < opt.replay; i++) {
+			begin_frame(back);
+			drawlist_execute(&g_draw_list, back);
+		}
+		uint64_t elapsed = now_us() - t0;
+		printf("replay us: mean %llu over %d runs, %d commands\n",
+			(unsigned long long)(elapsed / opt.replay), opt.replay, g_draw_list.cmd_count);
+	}
+
+	if (opt.timing_path) {
+		FILE* f = fopen(opt.timing_path, "w");
+		if (f) {
+			fprintf(f, "frame,update_us,render_us,frame_us,lcd_rows,steps\n");
+			for (int i = 0; i < opt.frames; i++) {
+				fprintf(f, "%d,%u,%u,%u,%d,%d\n", i, timings[i].update_us, timings[i].render_us,
+					timings[i].frame_us, timings[i].lcd_rows, timings[i].steps);
+			}
+			fclose(f);
+		} else {
+			fprintf(stderr, "cannot write %s\n", opt.timing_path);
+			failures++;
+		}
+	}
+
+	game_destroy();
+	free(timings);
+	free(rgb);
+	lcd_sim_free();
+	free(frames[0].framebuf);
+	free(frames[1].framebuf);
+	free(frames[0].indexbuf);
+	free(frames[1].indexbuf);
+
+	if (failures) {
+		printf("%d failure(s)\n", failures);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,110 @@
+#include "scene.h"
+#include "drawlist.h"
+#include "fixmath.h"
+#include <stddef.h>
+
+#define SCENE_MAX_WIDTH 1024
+#define HILL_POINTS 16
+#define STAR_POINTS 90
+#define RING_POINTS 96
+#define GRADIENT_ROWS 12
+
+static DrawList list;
+static uint32_t rng_state;
+static int hills[HILL_POINTS];
+static int star_radius[STAR_POINTS];
+static int16_t tops[SCENE_MAX_WIDTH];
+static ColorSpan gradient[GRADIENT_ROWS];
+
+static uint32_t scene_rand(void)
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+void scene_init(uint32_t seed)
+{
+	rng_state = seed ? seed : 1;
+	for (int i = 0; i < HILL_POINTS; i++) {
+		hills[i] = scene_rand() % 256;
+	}
+	for (int i = 0; i < STAR_POINTS; i++) {
+		star_radius[i] = 128 + (i & 1 ? 0 : scene_rand() % 128);
+	}
+}
+
+// height of the hills at x, 0..255, the points wrap around
+static int hill_at(int x, int period)
+{
+	int seg = period / HILL_POINTS;
+	int i = x / seg % HILL_POINTS;
+	int f = x % seg;
+	return hills[i] + (hills[(i + 1) % HILL_POINTS] - hills[i]) * f / seg;
+}
+
+// `count` points around (cx, cy) at `r` * radius[i] / 256, turned by `deg`
+static void ring(vec2d* out, int count, int cx, int cy, int r, const int* radius, int deg)
+{
+	for (int i = 0; i < count; i++) {
+		int a = deg + i * 360 / count;
+		int len = radius ? r * radius[i] / 256 : r;
+		out[i] = (vec2d){
+			cx + (int)(((int64_t)len * fix_cos_deg(a)) >> FIX16_SHIFT),
+			cy + (int)(((int64_t)len * fix_sin_deg(a)) >> FIX16_SHIFT)
+		};
+	}
+}
+
+void scene_draw(GraphicsContext* ctx, uint32_t time_ms)
+{
+	int w = ctx->width < SCENE_MAX_WIDTH ? ctx->width : SCENE_MAX_WIDTH;
+	int h = ctx->height;
+	int size = w < h ? w : h;
+	int t = time_ms / 16;
+	vec2d points[RING_POINTS];
+
+	begin_frame(ctx);
+	drawlist_begin(&list, ctx);
+
+	// scrolling hills, outlined by a chain of lines
+	drawlist_set_layer(&list, DL_LAYER_GROUND);
+	int period = w * 2;
+	for (int x = 0; x < w; x++) {
+		tops[x] = h - h / 8 - hill_at(x + t * 2, period) * h / 1024;
+	}
+	dl_columns(&list, 0, tops, w, RGB565(0x3a5f0b));
+	drawlist_set_layer(&list, DL_LAYER_TERRAIN);
+	for (int x = 0; x + 8 < w; x += 8) {
+		dl_line(&list, x, tops[x], x + 8, tops[x + 8], 2, RGB565(0x9acd32));
+	}
+
+	// a concave star past the polygon filler's stack arrays, and an outline
+	drawlist_set_layer(&list, DL_LAYER_BODIES);
+	int cx = w / 4 + t % (w / 2);
+	ring(points, STAR_POINTS, cx, h / 3, size / 5, star_radius, t * 3);
+	dl_polygon(&list, points, STAR_POINTS, RGB565(0xffa500));
+	ring(points, RING_POINTS, w - cx, h / 2, size / 6, NULL, -t);
+	dl_polygon_outline(&list, points, RING_POINTS, 3, RGB565(0x00bfff));
+
+	int bounce = t % 40 < 20 ? t % 40 : 40 - t % 40;
+	dl_solid_circle(&list, w / 2, h / 4 + bounce * h / 80, size / 12, RGB565(0xdc143c));
+	dl_circle(&list, w / 2, h / 2, size / 4, 2, RGB565(0xffffff));
+	dl_rect(&list, t % w, h / 2 + size / 5, size / 8, size / 10, RGB565(0x8a2be2));
+	dl_line(&list, 0, 0, w - 1, h - 1, 1, RGB565(0x808080));
+
+	// HUD: a bar and a gradient of spans under it
+	drawlist_set_layer(&list, DL_LAYER_HUD);
+	dl_rect(&list, 0, 0, w, h / 24 + 1, RGB565(0x202040));
+	for (int i = 0; i < GRADIENT_ROWS; i++) {
+		int v = i * 255 / (GRADIENT_ROWS - 1);
+		gradient[i] = (ColorSpan){
+			(int16_t)(w / 8), (int16_t)(h / 24 + 2 + i),
+			(uint16_t)(w / 4 + (t + i) % (w / 4)), RGB565(v << 16 | (255 - v))
+		};
+	}
+	dl_spans(&list, gradient, GRADIENT_ROWS);
+
+	drawlist_execute(&list, ctx);
+}
@@ -0,0 +1,13 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <stdint.h>
+#include "graphics.h"
+
+// Fixed test scene for golden images: every draw list primitive but text,
+// generated from a seed and moved by the game time. It uses neither Box2D
+// nor the font, so its frames are the same on any build of the rasterizer.
+void scene_init(uint32_t seed);
+void scene_draw(GraphicsContext* ctx, uint32_t time_ms);
+
+#endif
@@ -2,6 +2,7 @@
 #include "box2d/box2d.h"
 #include "game.h"
 #include "worldgen.h"
+#include "fixmath.h"
 #include <stdio.h>
 #include <math.h>
 
@@ -39,7 +40,7 @@ void car_create(b2WorldId worldId, b2Vec2 position) {
 	bodyDef.type = b2_dynamicBody;
 #endif
 	bodyDef.position = position;
-	g_car.chassis = worldgen_create_body(&bodyDef, BODY_TYPE_CAR_CHASSIS, bodyDef.position.x);
+	g_car.chassis = worldgen_create_body(&bodyDef, BODY_TYPE_CAR_CHASSIS);
 
 	b2Polygon car_shape = b2MakeBox(car_body_length / 2.0f, car_body_height / 2.0f);
 	b2ShapeDef shapeDef = b2DefaultShapeDef();
@@ -55,11 +56,11 @@ void car_create(b2WorldId worldId, b2Vec2 position) {
 	wheelBodyDef.type = b2_dynamicBody;
 
 	wheelBodyDef.position = b2Body_GetWorldPoint(g_car.chassis, (b2Vec2){-1.0f, 0.35f});
-	g_car.leftWheel = worldgen_create_body(&wheelBodyDef, BODY_TYPE_CAR_WHEEL, wheelBodyDef.position.x);
+	g_car.leftWheel = worldgen_create_body(&wheelBodyDef, BODY_TYPE_CAR_WHEEL);
 	b2CreateCircleShape(g_car.leftWheel, &shapeDef, &wheel_shape);
 
 	wheelBodyDef.position = b2Body_GetWorldPoint(g_car.chassis, (b2Vec2){1.0f, 0.35f});
-	g_car.rightWheel = worldgen_create_body(&wheelBodyDef, BODY_TYPE_CAR_WHEEL, wheelBodyDef.position.x);
+	g_car.rightWheel = worldgen_create_body(&wheelBodyDef, BODY_TYPE_CAR_WHEEL);
 	b2CreateCircleShape(g_car.rightWheel, &shapeDef, &wheel_shape);
 
 	// joints
@@ -84,9 +85,8 @@ void car_create(b2WorldId worldId, b2Vec2 position) {
 void car_update_state(void) {
 	g_car.prev_position = g_car.position;
 	g_car.position = b2Body_GetPosition(g_car.chassis);
-	g_car.angle_deg = b2Rot_GetAngle(b2Body_GetRotation(g_car.chassis)) * 180.0f / M_PI;
-	while (g_car.angle_deg < 0) g_car.angle_deg += 360;
-	while (g_car.angle_deg >= 360) g_car.angle_deg -= 360;
+	b2Rot rot = b2Body_GetRotation(g_car.chassis);
+	g_car.angle_deg = fix_atan2_deg(rot.s * FIX16_ONE, rot.c * FIX16_ONE);
 }
 
 static bool check_contacts(b2BodyId bodyId) {
@@ -138,9 +138,9 @@ void car_update_controls(int dt) {
 				power_level = POWER_HIGH;
 			}
 
-			float angle_rad = b2Rot_GetAngle(b2Body_GetRotation(g_car.chassis));
-			float force_angle = angle_rad;// - (15.0f * M_PI / 180.0f);
-			b2Vec2 force_dir = {cosf(force_angle), sinf(force_angle)};
+			// along the chassis, the rotation already holds its cos and sin
+			b2Rot rot = b2Body_GetRotation(g_car.chassis);
+			b2Vec2 force_dir = {rot.c, rot.s};
 			b2Vec2 force = b2MulSV(power_level, force_dir);
 			b2Body_ApplyForceToCenter(g_car.chassis, force, true);
 
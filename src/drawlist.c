@@ -0,0 +1,450 @@
+#include "drawlist.h"
+#include <string.h>
+
+static DrawListExecFn executor;
+
+typedef struct {
+	vec2d points[DL_MAX_POLYLINE];
+	int count;
+	uint16_t color;
+	int thickness;
+} Polyline;
+
+void drawlist_begin(DrawList* list, GraphicsContext* target)
+{
+	list->cmd_count = 0;
+	list->vert_count = 0;
+	list->text_size = 0;
+	list->layer = DL_LAYER_TERRAIN;
+	list->target = target;
+	list->capture_cmd = -1;
+	memset(&list->stats, 0, sizeof(list->stats));
+}
+
+void drawlist_set_layer(DrawList* list, int layer)
+{
+	list->layer = layer;
+}
+
+// Stable bucket sort of [start, end) by layer into list->order. Commands of
+// unordered layers are then grouped by type and color so lines of the same
+// style end up next to each other.
+static int build_order(DrawList* list, int start, int end)
+{
+	int next[DL_LAYER_COUNT] = {0};
+	for (int i = start; i < end; i++) {
+		for (int l = list->cmds[i].layer + 1; l < DL_LAYER_COUNT; l++) {
+			next[l]++;
+		}
+	}
+	int first[DL_LAYER_COUNT];
+	memcpy(first, next, sizeof(first));
+	for (int i = start; i < end; i++) {
+		list->order[next[list->cmds[i].layer]++] = i;
+	}
+
+	for (int l = 0; l < DL_LAYER_COUNT; l++) {
+		if (!(DL_UNORDERED_LAYERS & 1 << l)) continue;
+		// insertion sort: already grouped input stays linear
+		for (int i = first[l] + 1; i < next[l]; i++) {
+			uint16_t idx = list->order[i];
+			const DrawCmd* cmd = &list->cmds[idx];
+			uint32_t key = (uint32_t)cmd->type << 16 | cmd->color;
+			int j = i - 1;
+			while (j >= first[l]) {
+				const DrawCmd* other = &list->cmds[list->order[j]];
+				if (((uint32_t)other->type << 16 | other->color) <= key) break;
+				list->order[j + 1] = list->order[j];
+				j--;
+			}
+			list->order[j + 1] = idx;
+		}
+	}
+	return end - start;
+}
+
+// `dy` is added to every y coordinate, it moves commands into a band context.
+static bool cmd_outside(const DrawList* list, const DrawCmd* cmd, const GraphicsContext* ctx, int dy)
+{
+	int x0, y0, x1, y1, pad;
+
+	switch (cmd->type) {
+		case DL_CMD_LINE:
+			x0 = cmd->as.line.x0 < cmd->as.line.x1 ? cmd->as.line.x0 : cmd->as.line.x1;
+			x1 = cmd->as.line.x0 < cmd->as.line.x1 ? cmd->as.line.x1 : cmd->as.line.x0;
+			y0 = cmd->as.line.y0 < cmd->as.line.y1 ? cmd->as.line.y0 : cmd->as.line.y1;
+			y1 = cmd->as.line.y0 < cmd->as.line.y1 ? cmd->as.line.y1 : cmd->as.line.y0;
+			pad = cmd->thickness + 1;
+			break;
+		case DL_CMD_POLYGON:
+		case DL_CMD_POLYGON_OUTLINE: {
+			const vec2d* v = &list->verts[cmd->as.poly.first];
+			x0 = x1 = v[0].x;
+			y0 = y1 = v[0].y;
+			for (int i = 1; i < cmd->as.poly.count; i++) {
+				if (v[i].x < x0) x0 = v[i].x;
+				if (v[i].x > x1) x1 = v[i].x;
+				if (v[i].y < y0) y0 = v[i].y;
+				if (v[i].y > y1) y1 = v[i].y;
+			}
+			pad = cmd->type == DL_CMD_POLYGON ? 0 : cmd->thickness + 1;
+			break;
+		}
+		case DL_CMD_CIRCLE:
+		case DL_CMD_SOLID_CIRCLE:
+			x0 = cmd->as.circle.x - cmd->as.circle.r;
+			x1 = cmd->as.circle.x + cmd->as.circle.r;
+			y0 = cmd->as.circle.y - cmd->as.circle.r;
+			y1 = cmd->as.circle.y + cmd->as.circle.r;
+			pad = 1;
+			break;
+		case DL_CMD_RECT:
+			x0 = cmd->as.rect.x;
+			x1 = cmd->as.rect.x + cmd->as.rect.w - 1;
+			y0 = cmd->as.rect.y;
+			y1 = cmd->as.rect.y + cmd->as.rect.h - 1;
+			pad = 0;
+			break;
+		default:
+			return false;
+	}
+	return x1 + pad < 0 || x0 - pad >= ctx->width || y1 + dy + pad < 0 || y0 + dy - pad >= ctx->height;
+}
+
+static void polyline_flush(Polyline* pl, GraphicsContext* ctx)
+{
+	if (pl->count >= 2) {
+		draw_polyline(ctx, pl->points, pl->count, pl->thickness, pl->color);
+	}
+	pl->count = 0;
+}
+
+#define SHIFT_CHUNK 64
+
+static const vec2d* shift_points(const vec2d* points, int count, int dy, vec2d* out)
+{
+	if (dy == 0) return points;
+	for (int i = 0; i < count; i++) {
+		out[i] = (vec2d){points[i].x, points[i].y + dy};
+	}
+	return out;
+}
+
+// Commands hold RGB565 colors; an indexed target gets them as palette
+// indices. The colors are added to the palette before execution starts,
+// so lookups from concurrent bands don't modify it.
+static inline uint16_t target_color(const GraphicsContext* ctx, uint16_t color)
+{
+	return ctx->indexbuf ? palette_find(ctx->palette, color) : color;
+}
+
+static void add_colors(const DrawList* list, int start, int end, GraphicsContext* ctx)
+{
+	if (!ctx->indexbuf) return;
+	for (int i = start; i < end; i++) {
+		const DrawCmd* cmd = &list->cmds[i];
+		if (cmd->type == DL_CMD_SPANS) {
+			for (int j = 0; j < cmd->as.spans.count; j++) {
+				palette_add(ctx->palette, cmd->as.spans.spans[j].color);
+			}
+		} else {
+			palette_add(ctx->palette, cmd->color);
+		}
+	}
+}
+
+static void draw_spans_shifted(GraphicsContext* ctx, const ColorSpan* spans, int count, int dy)
+{
+	if (dy == 0 && !ctx->indexbuf) {
+		draw_spans(ctx, spans, count);
+		return;
+	}
+	ColorSpan chunk[SHIFT_CHUNK];
+	for (int i = 0; i < count; i += SHIFT_CHUNK) {
+		int n = count - i < SHIFT_CHUNK ? count - i : SHIFT_CHUNK;
+		int used = 0;
+		for (int j = 0; j < n; j++) {
+			int y = spans[i + j].y + dy;
+			if (y < 0 || y >= ctx->height) continue;
+			chunk[used] = spans[i + j];
+			chunk[used].color = target_color(ctx, chunk[used].color);
+			chunk[used++].y = y;
+		}
+		draw_spans(ctx, chunk, used);
+	}
+}
+
+static void fill_columns_shifted(GraphicsContext* ctx, int x, const int16_t* tops, int count, int dy, uint16_t color)
+{
+	if (dy == 0) {
+		fill_columns(ctx, x, tops, count, color);
+		return;
+	}
+	int16_t chunk[SHIFT_CHUNK];
+	for (int i = 0; i < count; i += SHIFT_CHUNK) {
+		int n = count - i < SHIFT_CHUNK ? count - i : SHIFT_CHUNK;
+		for (int j = 0; j < n; j++) {
+			chunk[j] = tops[i + j] + dy;
+		}
+		fill_columns(ctx, x + i, chunk, n, color);
+	}
+}
+
+// `scratch` takes the shifted vertices of a polygon, it is only used when
+// `dy` isn't 0
+static void execute_cmd(const DrawList* list, const DrawCmd* cmd, GraphicsContext* ctx, int dy, vec2d* scratch)
+{
+	uint16_t color = target_color(ctx, cmd->color);
+
+	switch (cmd->type) {
+		case DL_CMD_POLYGON:
+		case DL_CMD_POLYGON_OUTLINE: {
+			const vec2d* v = &list->verts[cmd->as.poly.first];
+			int count = cmd->as.poly.count;
+			v = shift_points(v, count, dy, scratch);
+			if (cmd->type == DL_CMD_POLYGON) {
+				fill_polygon(ctx, v, count, color);
+			} else {
+				draw_polygon(ctx, v, count, cmd->thickness, color);
+			}
+			break;
+		}
+		case DL_CMD_CIRCLE:
+			draw_circle(ctx, cmd->as.circle.x, cmd->as.circle.y + dy, cmd->as.circle.r, cmd->thickness, color);
+			break;
+		case DL_CMD_SOLID_CIRCLE:
+			draw_solid_circle(ctx, cmd->as.circle.x, cmd->as.circle.y + dy, cmd->as.circle.r, color);
+			break;
+		case DL_CMD_RECT:
+			fill_rect(ctx, cmd->as.rect.x, cmd->as.rect.y + dy, cmd->as.rect.w, cmd->as.rect.h, color);
+			break;
+		case DL_CMD_SPANS:
+			draw_spans_shifted(ctx, cmd->as.spans.spans, cmd->as.spans.count, dy);
+			break;
+		case DL_CMD_TEXT:
+			draw_text(ctx, &list->text[cmd->as.text.offset], cmd->as.text.x, cmd->as.text.y + dy, color, cmd->as.text.anchor);
+			break;
+		case DL_CMD_COLUMNS:
+			fill_columns_shifted(ctx, cmd->as.columns.x, cmd->as.columns.tops, cmd->as.columns.count, dy, color);
+			break;
+	}
+}
+
+// Runs the first `count` entries of list->order. Stats are only updated
+// when `stats` is given; band workers run concurrently and pass NULL.
+static void run_order(const DrawList* list, int count, GraphicsContext* ctx, int dy, vec2d* scratch, DrawListStats* stats)
+{
+	Polyline pl;
+	pl.count = 0;
+
+	for (int k = 0; k < count; k++) {
+		const DrawCmd* cmd = &list->cmds[list->order[k]];
+
+		if (cmd_outside(list, cmd, ctx, dy)) {
+			if (stats) stats->culled++;
+			polyline_flush(&pl, ctx);
+			continue;
+		}
+
+		if (cmd->type == DL_CMD_LINE) {
+			// chain onto the open polyline when the style matches and it starts where that one ends
+			vec2d a = {cmd->as.line.x0, cmd->as.line.y0 + dy};
+			vec2d b = {cmd->as.line.x1, cmd->as.line.y1 + dy};
+			uint16_t color = target_color(ctx, cmd->color);
+			if (pl.count > 0 && pl.count < DL_MAX_POLYLINE &&
+			    pl.color == color && pl.thickness == cmd->thickness &&
+			    pl.points[pl.count - 1].x == a.x && pl.points[pl.count - 1].y == a.y) {
+				pl.points[pl.count++] = b;
+				if (stats) stats->merged++;
+				continue;
+			}
+			polyline_flush(&pl, ctx);
+			pl.points[0] = a;
+			pl.points[1] = b;
+			pl.count = 2;
+			pl.color = color;
+			pl.thickness = cmd->thickness;
+			continue;
+		}
+
+		polyline_flush(&pl, ctx);
+		execute_cmd(list, cmd, ctx, dy, scratch);
+	}
+	polyline_flush(&pl, ctx);
+}
+
+static void execute_range(DrawList* list, int start, int end, GraphicsContext* ctx)
+{
+	add_colors(list, start, end, ctx);
+	int count = build_order(list, start, end);
+	run_order(list, count, ctx, 0, NULL, &list->stats);
+}
+
+void drawlist_set_executor(DrawListExecFn fn)
+{
+	executor = fn;
+}
+
+void drawlist_execute(DrawList* list, GraphicsContext* ctx)
+{
+	if (executor) {
+		add_colors(list, 0, list->cmd_count, ctx);
+		executor(list, ctx);
+	} else {
+		drawlist_execute_serial(list, ctx);
+	}
+}
+
+void drawlist_execute_serial(DrawList* list, GraphicsContext* ctx)
+{
+	execute_range(list, 0, list->cmd_count, ctx);
+}
+
+void drawlist_sort(DrawList* list)
+{
+	list->order_count = build_order(list, 0, list->cmd_count);
+}
+
+void drawlist_execute_band(const DrawList* list, GraphicsContext* band, int band_y, vec2d* scratch)
+{
+	run_order(list, list->order_count, band, -band_y, scratch, NULL);
+}
+
+void drawlist_begin_capture(DrawList* list)
+{
+	list->capture_cmd = list->cmd_count;
+	list->capture_vert = list->vert_count;
+	list->capture_text = list->text_size;
+}
+
+void drawlist_end_capture(DrawList* list, GraphicsContext* ctx)
+{
+	execute_range(list, list->capture_cmd, list->cmd_count, ctx);
+	list->cmd_count = list->capture_cmd;
+	list->vert_count = list->capture_vert;
+	list->text_size = list->capture_text;
+	list->capture_cmd = -1;
+}
+
+// Makes room for a command. A full list is rasterized into its target and
+// emptied, unless a capture is open or there is no target.
+static DrawCmd* add_cmd(DrawList* list, int type, uint16_t color, int verts, int text)
+{
+	if (list->cmd_count == DL_MAX_COMMANDS || list->vert_count + verts > DL_MAX_VERTICES ||
+	    list->text_size + text > DL_MAX_TEXT) {
+		if (list->capture_cmd >= 0 || !list->target || verts > DL_MAX_VERTICES || text > DL_MAX_TEXT) {
+			list->stats.dropped++;
+			return NULL;
+		}
+		drawlist_execute(list, list->target);
+		list->cmd_count = 0;
+		list->vert_count = 0;
+		list->text_size = 0;
+		list->stats.flushes++;
+	}
+
+	DrawCmd* cmd = &list->cmds[list->cmd_count++];
+	cmd->type = type;
+	cmd->layer = list->layer;
+	cmd->color = color;
+	cmd->thickness = 0;
+	list->stats.commands++;
+	return cmd;
+}
+
+void dl_line(DrawList* list, int x0, int y0, int x1, int y1, int thickness, uint16_t color)
+{
+	DrawCmd* cmd = add_cmd(list, DL_CMD_LINE, color, 0, 0);
+	if (!cmd) return;
+	cmd->thickness = thickness;
+	cmd->as.line.x0 = x0;
+	cmd->as.line.y0 = y0;
+	cmd->as.line.x1 = x1;
+	cmd->as.line.y1 = y1;
+}
+
+static void add_poly(DrawList* list, int type, const vec2d* vertices, int count, int thickness, uint16_t color)
+{
+	if (count <= 0) return;
+	DrawCmd* cmd = add_cmd(list, type, color, count, 0);
+	if (!cmd) return;
+	cmd->thickness = thickness;
+	cmd->as.poly.first = list->vert_count;
+	cmd->as.poly.count = count;
+	memcpy(&list->verts[list->vert_count], vertices, count * sizeof(vec2d));
+	list->vert_count += count;
+}
+
+void dl_polygon(DrawList* list, const vec2d* vertices, int count, uint16_t color)
+{
+	add_poly(list, DL_CMD_POLYGON, vertices, count, 0, color);
+}
+
+void dl_polygon_outline(DrawList* list, const vec2d* vertices, int count, int thickness, uint16_t color)
+{
+	add_poly(list, DL_CMD_POLYGON_OUTLINE, vertices, count, thickness, color);
+}
+
+void dl_circle(DrawList* list, int x, int y, int r, int thickness, uint16_t color)
+{
+	DrawCmd* cmd = add_cmd(list, DL_CMD_CIRCLE, color, 0, 0);
+	if (!cmd) return;
+	cmd->thickness = thickness;
+	cmd->as.circle.x = x;
+	cmd->as.circle.y = y;
+	cmd->as.circle.r = r;
+}
+
+void dl_solid_circle(DrawList* list, int x, int y, int r, uint16_t color)
+{
+	DrawCmd* cmd = add_cmd(list, DL_CMD_SOLID_CIRCLE, color, 0, 0);
+	if (!cmd) return;
+	cmd->as.circle.x = x;
+	cmd->as.circle.y = y;
+	cmd->as.circle.r = r;
+}
+
+void dl_rect(DrawList* list, int x, int y, int w, int h, uint16_t color)
+{
+	DrawCmd* cmd = add_cmd(list, DL_CMD_RECT, color, 0, 0);
+	if (!cmd) return;
+	cmd->as.rect.x = x;
+	cmd->as.rect.y = y;
+	cmd->as.rect.w = w;
+	cmd->as.rect.h = h;
+}
+
+// The spans are referenced, not copied; they must stay valid until the
+// list is executed for the last time.
+void dl_spans(DrawList* list, const ColorSpan* spans, int count)
+{
+	if (count <= 0) return;
+	DrawCmd* cmd = add_cmd(list, DL_CMD_SPANS, 0, 0, 0);
+	if (!cmd) return;
+	cmd->as.spans.spans = spans;
+	cmd->as.spans.count = count;
+}
+
+void dl_text(DrawList* list, const char* text, int x, int y, uint16_t color, int anchor)
+{
+	int size = strlen(text) + 1;
+	DrawCmd* cmd = add_cmd(list, DL_CMD_TEXT, color, 0, size);
+	if (!cmd) return;
+	cmd->as.text.x = x;
+	cmd->as.text.y = y;
+	cmd->as.text.anchor = anchor;
+	cmd->as.text.offset = list->text_size;
+	memcpy(&list->text[list->text_size], text, size);
+	list->text_size += size;
+}
+
+// Like dl_spans(), `tops` is referenced and must outlive the list.
+void dl_columns(DrawList* list, int x, const int16_t* tops, int count, uint16_t color)
+{
+	if (count <= 0) return;
+	DrawCmd* cmd = add_cmd(list, DL_CMD_COLUMNS, color, 0, 0);
+	if (!cmd) return;
+	cmd->as.columns.x = x;
+	cmd->as.columns.tops = tops;
+	cmd->as.columns.count = count;
+}
@@ -0,0 +1,113 @@
+#ifndef DRAWLIST_H
+#define DRAWLIST_H
+
+#include "graphics.h"
+
+#define DL_MAX_COMMANDS 1024
+#define DL_MAX_VERTICES 1024
+#define DL_MAX_TEXT 512
+#define DL_MAX_POLYLINE 128
+
+enum DrawCmdType {
+	DL_CMD_LINE,
+	DL_CMD_POLYGON,
+	DL_CMD_POLYGON_OUTLINE,
+	DL_CMD_CIRCLE,
+	DL_CMD_SOLID_CIRCLE,
+	DL_CMD_RECT,
+	DL_CMD_SPANS,
+	DL_CMD_TEXT,
+	DL_CMD_COLUMNS
+};
+
+// Layers are drawn in this order. Inside an unordered layer the backend
+// may reorder commands to batch them.
+enum DrawLayer {
+	DL_LAYER_GROUND,
+	DL_LAYER_TERRAIN,
+	DL_LAYER_BODIES,
+	DL_LAYER_HUD,
+	DL_LAYER_COUNT
+};
+
+#define DL_UNORDERED_LAYERS (1 << DL_LAYER_TERRAIN)
+
+typedef struct DrawCmd {
+	uint8_t type;
+	uint8_t layer;
+	uint16_t color;
+	int thickness;
+	union {
+		struct { int x0, y0, x1, y1; } line;
+		struct { int first, count; } poly;   // vertex arena range
+		struct { int x, y, r; } circle;
+		struct { int x, y, w, h; } rect;
+		struct { const ColorSpan* spans; int count; } spans;
+		struct { int x, y, anchor, offset; } text; // offset into the text arena
+		struct { int x; const int16_t* tops; int count; } columns;
+	} as;
+} DrawCmd;
+
+typedef struct DrawListStats {
+	int commands;
+	int culled;
+	int merged;  // line commands folded into a polyline
+	int flushes; // early executions because an arena was full
+	int dropped;
+} DrawListStats;
+
+// One frame of draw commands. Game code fills it, drawlist_execute()
+// rasterizes it. Executing does not consume the list, so a frame can be
+// replayed until the next drawlist_begin().
+typedef struct DrawList {
+	DrawCmd cmds[DL_MAX_COMMANDS];
+	int cmd_count;
+	vec2d verts[DL_MAX_VERTICES];
+	int vert_count;
+	char text[DL_MAX_TEXT];
+	int text_size;
+	uint16_t order[DL_MAX_COMMANDS];
+	int order_count;
+	uint8_t layer;
+	GraphicsContext* target; // where a full list is flushed to
+	int capture_cmd;         // start of the capture range, -1 if none
+	int capture_vert;
+	int capture_text;
+	DrawListStats stats;
+} DrawList;
+
+typedef void (*DrawListExecFn)(DrawList* list, GraphicsContext* ctx);
+
+void drawlist_begin(DrawList* list, GraphicsContext* target);
+void drawlist_set_layer(DrawList* list, int layer);
+void drawlist_execute(DrawList* list, GraphicsContext* ctx);
+void drawlist_execute_serial(DrawList* list, GraphicsContext* ctx);
+
+// Replaces the rasterizer pass used by drawlist_execute(), NULL restores
+// the serial one.
+void drawlist_set_executor(DrawListExecFn fn);
+
+// Banded execution: sort once, then each band renders the sorted list into
+// a context covering rows [band_y, band_y + band->height) of the frame.
+// Polygons are moved into the band through `scratch`, room for
+// DL_MAX_VERTICES points that no other thread uses meanwhile. Bands share
+// no other state and may run on different threads.
+void drawlist_sort(DrawList* list);
+void drawlist_execute_band(const DrawList* list, GraphicsContext* band, int band_y, vec2d* scratch);
+
+// Commands added between begin and end capture are rasterized into `ctx`
+// by end capture and then removed from the list.
+void drawlist_begin_capture(DrawList* list);
+void drawlist_end_capture(DrawList* list, GraphicsContext* ctx);
+
+void dl_line(DrawList* list, int x0, int y0, int x1, int y1, int thickness, uint16_t color);
+void dl_polygon(DrawList* list, const vec2d* vertices, int count, uint16_t color);
+void dl_polygon_outline(DrawList* list, const vec2d* vertices, int count, int thickness, uint16_t color);
+void dl_circle(DrawList* list, int x, int y, int r, int thickness, uint16_t color);
+void dl_solid_circle(DrawList* list, int x, int y, int r, uint16_t color);
+void dl_rect(DrawList* list, int x, int y, int w, int h, uint16_t color);
+void dl_spans(DrawList* list, const ColorSpan* spans, int count);
+void dl_text(DrawList* list, const char* text, int x, int y, uint16_t color, int anchor);
+void dl_columns(DrawList* list, int x, const int16_t* tops, int count, uint16_t color);
+
+#endif
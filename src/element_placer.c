@@ -1,10 +1,100 @@
 #include "element_placer.h"
 #include "worldgen.h"
 #include "game.h"
+#include "quality.h"
+#include "fixmath.h"
 #include <stdlib.h>
-#include <math.h>
 
-#define DETAIL_LEVEL 1
+// Set by the generator from the quality tier, it may run on its own
+// thread. At detail one, sines take a point every 30 degrees and arcs one
+// every 10.
+static int detail = QUALITY_DETAIL_ONE;
+#define SIN_STEP (30 * QUALITY_DETAIL_ONE / detail)
+#define ARC_SEGMENTS(angle) ((angle) * detail / (10 * QUALITY_DETAIL_ONE))
+
+// how far in emini units the decimated terrain may stray from the sampled
+// curve, about a pixel at the default zoom
+#ifndef DECIMATE_TOLERANCE
+#define DECIMATE_TOLERANCE 3
+#endif
+
+static int saved_segments;
+
+// emini position plus Q16.16 offsets, in Box2D meters
+static b2Vec2 to_world(int x, fix16 dx, int y, fix16 dy)
+{
+	return (b2Vec2){(x + dx / (float)FIX16_ONE) / WORLD_SCALE, (y + dy / (float)FIX16_ONE) / WORLD_SCALE};
+}
+
+static float segment_distance_sq(b2Vec2 p, b2Vec2 a, b2Vec2 b)
+{
+	b2Vec2 ab = b2Sub(b, a);
+	b2Vec2 ap = b2Sub(p, a);
+	float len_sq = b2Dot(ab, ab);
+	float t = len_sq > 0 ? b2Dot(ap, ab) / len_sq : 0;
+	t = CONSTRAIN(0, t, 1);
+	b2Vec2 d = b2Sub(ap, b2MulSV(t, ab));
+	return b2Dot(d, d);
+}
+
+// Douglas-Peucker with an explicit stack. The endpoints always stay, so
+// the element still ends where the structure expects it.
+static int decimate(b2Vec2* points, int count)
+{
+	if (count <= 2) return count;
+
+	float tolerance = DECIMATE_TOLERANCE / WORLD_SCALE;
+	float tolerance_sq = tolerance * tolerance;
+	bool keep[count];
+	int stack[count * 2];
+	int top = 0;
+
+	for (int i = 0; i < count; i++) keep[i] = false;
+	keep[0] = keep[count - 1] = true;
+	stack[top++] = 0;
+	stack[top++] = count - 1;
+
+	while (top > 0) {
+		int last = stack[--top];
+		int first = stack[--top];
+		int worst = -1;
+		float worst_sq = tolerance_sq;
+		for (int i = first + 1; i < last; i++) {
+			float d = segment_distance_sq(points[i], points[first], points[last]);
+			if (d > worst_sq) {
+				worst = i;
+				worst_sq = d;
+			}
+		}
+		if (worst < 0) continue;
+		keep[worst] = true;
+		// every split leaves two ranges of at least two points, so the
+		// stack never holds more than count pairs
+		stack[top++] = first;
+		stack[top++] = worst;
+		stack[top++] = worst;
+		stack[top++] = last;
+	}
+
+	int n = 0;
+	for (int i = 0; i < count; i++) {
+		if (keep[i]) points[n++] = points[i];
+	}
+	saved_segments += count - n;
+	return n;
+}
+
+void element_set_detail(int new_detail)
+{
+	detail = new_detail;
+}
+
+int element_take_saved_segments(void)
+{
+	int saved = saved_segments;
+	saved_segments = 0;
+	return saved;
+}
 
 void place_sin(int x, int y, int l, int half_periods, int start_angle, int amp)
 {
@@ -13,10 +103,11 @@ void place_sin(int x, int y, int l, int half_periods, int start_angle, int amp)
 			{x / WORLD_SCALE, y / WORLD_SCALE},
 			{(x + l) / WORLD_SCALE, y / WORLD_SCALE}
 		};
-		world_create_two_sided_landscape(points, 2, x);
+		world_add_landscape(points, 2, x);
+		return;
 	}
 
-	int step = 30 / DETAIL_LEVEL;
+	int step = SIN_STEP;
 	int end_angle = start_angle + half_periods * 180;
 	int angle = end_angle - start_angle;
 	if (angle == 0) angle = 1;
@@ -26,46 +117,41 @@ void place_sin(int x, int y, int l, int half_periods, int start_angle, int amp)
 	int point_count = 0;
 
 	for (int i = start_angle; i < end_angle; i += step) {
-		float px = x + (float)(i - start_angle) * l / (float)angle;
-		float py = y + amp * sinf(i * M_PI / 180.0f);
-		points[point_count++] = (b2Vec2){px / WORLD_SCALE, py / WORLD_SCALE};
+		fix16 dx = (fix16)(((int64_t)(i - start_angle) * l << FIX16_SHIFT) / angle);
+		points[point_count++] = to_world(x, dx, y, amp * fix_sin_deg(i));
 	}
 
-	float final_px = x + l;
-	float final_py = y + amp * sinf(end_angle * M_PI / 180.0f);
-	points[point_count++] = (b2Vec2){final_px / WORLD_SCALE, final_py / WORLD_SCALE};
+	points[point_count++] = to_world(x + l, 0, y, amp * fix_sin_deg(end_angle));
 
 	if (point_count > 1) {
-		world_create_two_sided_landscape(points, point_count, x);
+		point_count = decimate(points, point_count);
+		world_add_landscape(points, point_count, x);
 	}
 }
 
 void place_scaled_arc(int x, int y, int r, int angle_deg, int start_angle_deg, int kx, int ky)
 {
-	float scale_x = kx / 10.0f;
-	float scale_y = ky / 10.0f;
-
-	float step_rad = (M_PI * 10.0f / (140.0f + r)) / 180.0f / 2 / DETAIL_LEVEL;
-	step_rad = CONSTRAIN(M_PI * 10.0f / 180.0f / DETAIL_LEVEL, step_rad, M_PI * 72.0f / 180.0f / DETAIL_LEVEL);
-
-	float start_angle_rad = start_angle_deg * M_PI / 180.0f;
-	float end_angle_rad = start_angle_rad + (angle_deg * M_PI / 180.0f);
+	// the radii scaled by kx / 10 and ky / 10
+	int rx = r * kx;
+	int ry = r * ky;
 
-	int num_segments = (int)(fabsf(angle_deg * M_PI / 180.0f) / step_rad);
+	int num_segments = ARC_SEGMENTS(abs(angle_deg));
 	if (num_segments < 1) num_segments = 1;
 
 	b2Vec2 points[num_segments + 2];
 	int point_count = 0;
 
+	// points fall on whole degrees, spaced to within a degree
 	for (int i = num_segments; i >= 0; i--) {
-		float current_angle = start_angle_rad + (float)i * (end_angle_rad - start_angle_rad) / (float)num_segments;
-		float px = x + cosf(current_angle) * scale_x * r;
-		float py = y + sinf(current_angle) * scale_y * r;
-		points[point_count++] = (b2Vec2){px / WORLD_SCALE, py / WORLD_SCALE};
+		int current_angle = start_angle_deg + div_round(i * angle_deg, num_segments);
+		fix16 dx = (fix16)((int64_t)fix_cos_deg(current_angle) * rx / 10);
+		fix16 dy = (fix16)((int64_t)fix_sin_deg(current_angle) * ry / 10);
+		points[point_count++] = to_world(x, dx, y, dy);
 	}
 
 	if (point_count > 1) {
-		world_create_two_sided_landscape(points, point_count, x + r);
+		point_count = decimate(points, point_count);
+		world_add_landscape(points, point_count, x + r);
 	}
 }
 
@@ -83,5 +169,5 @@ void place_line(int x1, int y1, int x2, int y2)
 		{x2 / WORLD_SCALE, y2 / WORLD_SCALE},
 	};
 
-	world_create_two_sided_landscape(platform_points, 4, fmaxf(x1, x2));
+	world_add_landscape(platform_points, 4, x1 > x2 ? x1 : x2);
 }
@@ -9,4 +9,10 @@ void place_arc(int x, int y, int r, int angle_deg, int start_angle_deg);
 
 void place_line(int x1, int y1, int x2, int y2);
 
+// tessellation in QUALITY_DETAIL_ONE units
+void element_set_detail(int detail);
+// Curves are decimated as they are placed. Returns the segments saved
+// since the last call.
+int element_take_saved_segments(void);
+
 #endif
@@ -0,0 +1,78 @@
+#include "fixmath.h"
+
+// sin of 0..90 degrees
+static const int32_t sin_table[91] = {
+	0, 1144, 2287, 3430, 4572, 5712, 6850, 7987, 9121, 10252,
+	11380, 12505, 13626, 14742, 15855, 16962, 18064, 19161, 20252, 21336,
+	22415, 23486, 24550, 25607, 26656, 27697, 28729, 29753, 30767, 31772,
+	32768, 33754, 34729, 35693, 36647, 37590, 38521, 39441, 40348, 41243,
+	42126, 42995, 43852, 44695, 45525, 46341, 47143, 47930, 48703, 49461,
+	50203, 50931, 51643, 52339, 53020, 53684, 54332, 54963, 55578, 56175,
+	56756, 57319, 57865, 58393, 58903, 59396, 59870, 60326, 60764, 61183,
+	61584, 61966, 62328, 62672, 62997, 63303, 63589, 63856, 64104, 64332,
+	64540, 64729, 64898, 65048, 65177, 65287, 65376, 65446, 65496, 65526,
+	65536,
+};
+
+// tan of 0.5..44.5 degrees, where the nearest whole degree changes
+static const int32_t tan_bounds[45] = {
+	572, 1716, 2861, 4008, 5158, 6310, 7467, 8628, 9794, 10967,
+	12146, 13333, 14529, 15734, 16949, 18175, 19413, 20663, 21928, 23208,
+	24503, 25815, 27146, 28496, 29866, 31259, 32675, 34116, 35583, 37078,
+	38604, 40161, 41751, 43377, 45042, 46746, 48494, 50288, 52130, 54024,
+	55973, 57981, 60053, 62191, 64402,
+};
+
+fix16 fix_sin_deg(int deg)
+{
+	deg %= 360;
+	if (deg < 0) deg += 360;
+	if (deg <= 90) return sin_table[deg];
+	if (deg <= 180) return sin_table[180 - deg];
+	if (deg <= 270) return -sin_table[deg - 180];
+	return -sin_table[360 - deg];
+}
+
+fix16 fix_cos_deg(int deg)
+{
+	return fix_sin_deg(deg % 360 + 90);
+}
+
+int fix_atan2_deg(int32_t y, int32_t x)
+{
+	uint32_t ax = x < 0 ? -(uint32_t)x : (uint32_t)x;
+	uint32_t ay = y < 0 ? -(uint32_t)y : (uint32_t)y;
+	if (ax == 0 && ay == 0) return 0;
+
+	// fold into the first octant, the ratio is then at most 1
+	bool steep = ay > ax;
+	uint32_t t = (uint32_t)(((uint64_t)(steep ? ax : ay) << FIX16_SHIFT) / (steep ? ay : ax));
+	int lo = 0, hi = 45;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if ((uint32_t)tan_bounds[mid] < t) lo = mid + 1;
+		else hi = mid;
+	}
+
+	int deg = steep ? 90 - lo : lo;
+	if (x < 0) deg = 180 - deg;
+	if (y < 0) deg = 360 - deg;
+	return deg == 360 ? 0 : deg;
+}
+
+uint32_t isqrt64(uint64_t v)
+{
+	uint64_t res = 0;
+	uint64_t bit = (uint64_t)1 << 62;
+	while (bit > v) bit >>= 2;
+	while (bit) {
+		if (v >= res + bit) {
+			v -= res + bit;
+			res = (res >> 1) + bit;
+		} else {
+			res >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t)res;
+}
@@ -0,0 +1,48 @@
+#ifndef FIXMATH_H
+#define FIXMATH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Q16.16
+typedef int32_t fix16;
+
+#define FIX16_SHIFT 16
+#define FIX16_ONE (1 << FIX16_SHIFT)
+
+// (a * b) >> 16 with a 32-bit `a` and a signed 16-bit `b`. ARMv5TE's DSP
+// extension does this in one smulwb; elsewhere it's a widening multiply.
+static inline int32_t fix_mulw16(int32_t a, int32_t b)
+{
+#if defined(__ARM_FEATURE_DSP) && (!defined(__thumb__) || defined(__thumb2__))
+	int32_t r;
+	__asm__("smulwb %0, %1, %2" : "=r"(r) : "r"(a), "r"(b));
+	return r;
+#else
+	return (int32_t)(((int64_t)a * (int16_t)b) >> 16);
+#endif
+}
+
+// Q16.16 product, one smull on ARM
+static inline fix16 fix16_mul(fix16 a, fix16 b)
+{
+	return (fix16)(((int64_t)a * b) >> FIX16_SHIFT);
+}
+
+// n / d rounded to nearest with halves away from zero, so negative
+// quotients mirror positive ones; d > 0
+static inline int32_t div_round(int32_t n, int32_t d)
+{
+	return n >= 0 ? (n + d / 2) / d : (n - d / 2) / d;
+}
+
+// Table sines for whole degrees, in Q16.16.
+fix16 fix_sin_deg(int deg);
+fix16 fix_cos_deg(int deg);
+// Direction of (x, y) rounded to a whole degree in [0, 360), with the
+// world's y-down axis the angles grow clockwise like Box2D's.
+int fix_atan2_deg(int32_t y, int32_t x);
+// floor(sqrt(v))
+uint32_t isqrt64(uint64_t v);
+
+#endif
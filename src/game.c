@@ -2,10 +2,14 @@
 #include "game.h"
 #include "box2d/box2d.h"
 #include "worldgen.h"
+#include "overlay.h"
+#include "fixmath.h"
+#include "quality.h"
 #include "compat.h"
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #define POINTS_DIVIDER 2000
 
@@ -13,8 +17,10 @@
 #define GAME_OVER_STUCK_TIME_MS 1000
 #define DAMAGE_COOLDOWN_MS 200
 #define NO_COLOR 0x1000000
+#define GROUND_FILL_COLOR 0x151540
 
 bool g_is_paused;
+bool g_fill_ground;
 int score;
 int flip_indicator;
 int flip_state;
@@ -25,6 +31,7 @@ int tick;
 int debug_text_offset;
 int frame_count = 0;
 uint32_t fps_last_measured_time = 0;
+uint32_t last_draw_time = 0;
 int fps;
 int last_tick_time;
 int screen_width;
@@ -32,10 +39,86 @@ int screen_height;
 int screen_min_side;
 int zoom_out;
 int view_field;
-int offset_x;
-int offset_y;
 CarState g_car;
 WorldState g_world;
+DrawList g_draw_list;
+
+// Per-frame world-to-screen transform:
+//   screen = (world - origin) * scale + anchor
+// World points are emini units. The offset from the origin is taken in
+// 1/256 emini and pre-shifted so that `scale` fits the 16-bit operand of
+// fix_mulw16(); the product is then in 1/256 pixels.
+typedef struct {
+	b2Vec2 origin;              // world point under the anchor, meters
+	int32_t origin_x, origin_y; // the same in emini, rounded down
+	int32_t frac_x, frac_y;     // rest of the origin, pre-shifted like offsets
+	int32_t unit;               // emini to pre-shifted offset
+	float unit_per_meter;
+	int32_t scale;              // pixels per emini, Q16.16 reduced to 15 bits
+	int32_t anchor_x, anchor_y; // screen point of the origin, 1/256 pixels
+	fix16 full_scale;           // pixels per emini, Q16.16
+} Camera;
+
+static Camera camera;
+
+// visible world rectangle in emini, padded by half a terrain line
+static int view_min_x, view_max_x, view_min_y, view_max_y;
+
+// per screen column, the row the ground fill starts at, screen_height
+// where there is no ground
+static int16_t* ground_tops;
+static int ground_tops_size;
+
+static OverlayLayer damage_layer;
+static OverlayLayer score_layer;
+static OverlayLayer pause_layer;
+static bool paused_frame_shown;
+
+// Car transforms before the last physics step. Drawing happens between
+// steps, `render_alpha` of the way from these to the current ones.
+static b2BodyId interp_ids[3];
+static b2Transform interp_prev[3];
+static float render_alpha = 1.0f;
+
+static struct {
+	int bodies_drawn;
+	int bodies_culled;
+	int segments_drawn;
+	int segments_culled;
+} render_stats;
+
+static int draw_failures; // primitives skipped for lack of memory, all frames
+
+static void save_car_transforms(void)
+{
+	interp_ids[0] = g_car.chassis;
+	interp_ids[1] = g_car.leftWheel;
+	interp_ids[2] = g_car.rightWheel;
+	for (int i = 0; i < 3; i++) {
+		if (b2Body_IsValid(interp_ids[i])) {
+			interp_prev[i] = b2Body_GetTransform(interp_ids[i]);
+		}
+	}
+}
+
+static b2Transform body_render_transform(b2BodyId bodyId)
+{
+	b2Transform xf = b2Body_GetTransform(bodyId);
+	if (render_alpha >= 1.0f) return xf;
+	for (int i = 0; i < 3; i++) {
+		if (B2_ID_EQUALS(bodyId, interp_ids[i])) {
+			xf.p = b2Lerp(interp_prev[i].p, xf.p, render_alpha);
+			xf.q = b2NLerp(interp_prev[i].q, xf.q, render_alpha);
+			break;
+		}
+	}
+	return xf;
+}
+
+void game_set_render_alpha(fix16 alpha)
+{
+	render_alpha = (float)alpha / FIX16_ONE;
+}
 
 void game_init(void)
 {
@@ -64,52 +147,122 @@ void game_init(void)
 
 	score = 0;
 	next_score_target_x = (car_pos.x * WORLD_SCALE) + POINTS_DIVIDER;
+
+	save_car_transforms();
 }
 
 void game_destroy(void)
 {
 	worldgen_clear_body_list();
+	overlay_free(&damage_layer);
+	overlay_free(&score_layer);
+	overlay_free(&pause_layer);
+	free(ground_tops);
+	ground_tops = NULL;
+	ground_tops_size = 0;
 }
 
-static void update_camera(void)
+static void camera_set(Camera* cam, b2Vec2 origin, fix16 scale, int anchor_x, int anchor_y)
 {
-	float f = g_car.position.y / 10.0f - 1;
-	if (f < 0) {
-		f = -f;
+	int shift = 0;
+	cam->full_scale = scale;
+	cam->scale = scale;
+	while (cam->scale >= 1 << 15) {
+		cam->scale >>= 1;
+		shift++;
 	}
-	zoom_out = WORLD_SCALE * 10000 * (f + 2) / screen_min_side;
+	cam->unit = 256 << shift;
+	cam->unit_per_meter = WORLD_SCALE * cam->unit;
+
+	cam->origin = origin;
+	float ox = origin.x * WORLD_SCALE;
+	float oy = origin.y * WORLD_SCALE;
+	cam->origin_x = floorf(ox);
+	cam->origin_y = floorf(oy);
+	cam->frac_x = (ox - cam->origin_x) * cam->unit;
+	cam->frac_y = (oy - cam->origin_y) * cam->unit;
+	cam->anchor_x = anchor_x * 256;
+	cam->anchor_y = anchor_y * 256;
+}
+
+static inline vec2d camera_point(const Camera* cam, vec2d p)
+{
+	int32_t dx = (p.x - cam->origin_x) * cam->unit - cam->frac_x;
+	int32_t dy = (p.y - cam->origin_y) * cam->unit - cam->frac_y;
+	return (vec2d){
+		(fix_mulw16(dx, cam->scale) + cam->anchor_x) >> 8,
+		(fix_mulw16(dy, cam->scale) + cam->anchor_y) >> 8
+	};
+}
+
+// emini length to pixels
+static inline int camera_length(const Camera* cam, int length)
+{
+	return (length * cam->full_scale) >> FIX16_SHIFT;
+}
+
+// screen pixel offset to emini
+static inline int camera_unproject(const Camera* cam, int pixels)
+{
+	return pixels * FIX16_ONE / cam->full_scale;
+}
+
+static void update_camera(void)
+{
+	b2Vec2 car_pos = body_render_transform(g_car.chassis).p;
+	int car_y = floorf(car_pos.y * WORLD_SCALE);
+	int dist = abs(car_y - 1000);
+	if (dist > 2000000) dist = 2000000;
+	zoom_out = (dist + 2000) * 1000 / screen_min_side;
 
 #ifdef SLOW_CAMERA
-	b2Vec2 delta = b2Sub(g_car.position, (b2Vec2){g_world.camera_x, g_world.camera_y});
+	b2Vec2 delta = b2Sub(car_pos, (b2Vec2){g_world.camera_x, g_world.camera_y});
 	float follow_speed = 0.001f;
 	g_world.camera_x += delta.x * delta.x * delta.x * follow_speed;
 	g_world.camera_y += delta.y * delta.y * delta.y * follow_speed;
+#endif
+	int anchor_x = screen_width / 3;
+	// car_y goes far past 2000000 emini, times the screen side that overflows
+	int anchor_y = screen_height * 2 / 3 + (int)((int64_t)car_y * screen_min_side / 2000000);
+	anchor_y = CONSTRAIN(screen_height / 16, anchor_y, screen_height * 4 / 5);
+
+#ifdef DEBUG_PIXELS_PER_METER
+	fix16 scale = DEBUG_PIXELS_PER_METER * FIX16_ONE / WORLD_SCALE;
 #else
-	offset_x = -g_car.position.x * PIXELS_PER_METER + screen_width / 3;
-	offset_y = -g_car.position.y * PIXELS_PER_METER + screen_height * 2 / 3;
-	offset_y += g_car.position.y * screen_min_side / 20000;
-	offset_y = CONSTRAIN(-g_car.position.y * PIXELS_PER_METER + screen_height/16, offset_y, -g_car.position.y * PIXELS_PER_METER + screen_height*4/5);
+	fix16 scale = 1000 * FIX16_ONE / zoom_out;
 #endif
+	camera_set(&camera, car_pos, scale, anchor_x, anchor_y);
 	view_field = screen_width * zoom_out / 1000;
+
+	int margin = 10 + camera_unproject(&camera, 1) + 1;
+	view_min_x = camera.origin_x + camera_unproject(&camera, -anchor_x) - margin;
+	view_max_x = camera.origin_x + camera_unproject(&camera, screen_width - anchor_x) + margin;
+	view_min_y = camera.origin_y + camera_unproject(&camera, -anchor_y) - margin;
+	view_max_y = camera.origin_y + camera_unproject(&camera, screen_height - anchor_y) + margin;
+}
+
+static bool box_outside_view(int min_x, int min_y, int max_x, int max_y)
+{
+	return max_x < view_min_x || min_x > view_max_x || max_y < view_min_y || min_y > view_max_y;
 }
 
 static bool update_damage_and_gameover(void)
 {
-	if (sys_timer_ms() - g_car.last_damage_time < DAMAGE_COOLDOWN_MS) {
+	if (g_world.time_ms - g_car.last_damage_time < DAMAGE_COOLDOWN_MS) {
 		return false;
 	}
 
 	bool upside_down = (g_car.angle_deg > 140 && g_car.angle_deg < 220);
 
 	if ((upside_down && g_car.car_body_contacts) || g_car.position.y > 20.0f) {
-		g_car.last_damage_time = sys_timer_ms();
+		g_car.last_damage_time = g_world.time_ms;
 		if (g_car.damage < GAME_OVER_DAMAGE) {
 			g_car.damage++;
 		} else {
 			return true;
 		}
 	} else {
-		g_car.last_damage_time = sys_timer_ms();
+		g_car.last_damage_time = g_world.time_ms;
 		if (g_car.damage > 0) {
 			g_car.damage--;
 		}
@@ -208,18 +361,12 @@ static void update_distance_score(void)
 	}
 }
 
+// One fixed step of the simulation
 void game_update(int dt)
 {
-	last_tick_time = dt;
-	frame_count++;
-	uint32_t current_time = sys_timer_ms();
-	if (current_time - fps_last_measured_time >= 1000) {
-		fps = frame_count;
-		frame_count = 0;
-		fps_last_measured_time = current_time;
-	}
-
-	b2World_Step(g_world.worldId, dt / 1000.0f, 8);
+	save_car_transforms();
+	g_world.time_ms += dt;
+	b2World_Step(g_world.worldId, dt / 1000.0f, g_quality->substeps);
 
 	car_update_state();
 	car_check_contacts();
@@ -236,64 +383,92 @@ void game_update(int dt)
 	world_generator_tick();
 }
 
-static void draw_pause_screen(void)
+static void draw_pause_screen(DrawList* dl, int origin_x, int origin_y)
 {
 	uint16_t pause_line_color = RGB565(0x0000FF);
-	int d = screen_context.height / 40;
-	for (int i = 0; i <= screen_context.height; i++) {
-		draw_line(&screen_context, screen_context.width / 2, 0, d * i, screen_context.height, 1, pause_line_color);
+	int d = screen_height / 40;
+	for (int i = 0; i <= screen_height; i++) {
+		dl_line(dl, screen_width / 2 - origin_x, -origin_y, d * i - origin_x, screen_height - origin_y, 1, pause_line_color);
 	}
-	draw_text(&screen_context, "PAUSED", screen_context.width/2, screen_context.height/3, RGB565(0xFFFFFF), ANCHOR_HCENTER | ANCHOR_TOP);
+	dl_text(dl, "PAUSED", screen_width/2 - origin_x, screen_height/3 - origin_y, RGB565(0xFFFFFF), ANCHOR_HCENTER | ANCHOR_TOP);
 }
 
-static void game_draw_hud(void)
+static void draw_score(DrawList* dl, int origin_x, int origin_y)
 {
-	int w = screen_context.width;
-	int h = screen_context.height;
-
-	debug_text_offset = 0;
-
-	if (g_car.damage > 1) {
-		// red "!"
-		uint16_t red = RGB565(0xFF0000);
-		int base_size = h / 120;
-		if (base_size < 1) base_size = 1;
-		int x = w / 2 - base_size / 2;
-		int y = h / 3;
-		fill_rect(&screen_context, x, y, base_size, base_size * 5, red);
-		fill_rect(&screen_context, x, y + base_size * 6, base_size, base_size, red);
-
-		int blue = 127 * (GAME_OVER_DAMAGE - g_car.damage) / GAME_OVER_DAMAGE;
-		if (blue > 255) blue = 255;
-		if (blue < 0) blue = 0;
-		uint16_t color = RGB565(blue);
-
-		int overlay_h = h * g_car.damage / GAME_OVER_DAMAGE / 2;
-		fill_rect(&screen_context, 0, 0, w, overlay_h + 1, color);
-		fill_rect(&screen_context, 0, h - overlay_h, w, h, color);
-	}
-
 	char score_str[16];
 	sprintf(score_str, "%d", score);
 	int c_val = flip_indicator;
 	uint16_t score_color = RGB565((c_val << 16) | (c_val << 8) | 0xFF);
-	draw_text(&screen_context, score_str, w / 2, h * 15 / 16, score_color, ANCHOR_HCENTER | ANCHOR_BOTTOM);
+	dl_text(dl, score_str, screen_width / 2 - origin_x, screen_height * 15 / 16 - origin_y, score_color, ANCHOR_HCENTER | ANCHOR_BOTTOM);
+}
+
+// HUD layers are retained and only rebuilt when what they show changes.
+static void game_draw_hud(DrawList* dl)
+{
+	int w = screen_width;
+	int h = screen_height;
+
+	debug_text_offset = 0;
+	drawlist_set_layer(dl, DL_LAYER_HUD);
+
+	if (g_car.damage > 1 && g_quality->hud_effects) {
+		if (overlay_begin(&damage_layer, dl, g_car.damage)) {
+			// red "!"
+			uint16_t red = RGB565(0xFF0000);
+			int base_size = h / 120;
+			if (base_size < 1) base_size = 1;
+			int x = w / 2 - base_size / 2;
+			int y = h / 3;
+			overlay_add_rect(&damage_layer, x, y, base_size, base_size * 5, red);
+			overlay_add_rect(&damage_layer, x, y + base_size * 6, base_size, base_size, red);
+
+			int blue = 127 * (GAME_OVER_DAMAGE - g_car.damage) / GAME_OVER_DAMAGE;
+			if (blue > 255) blue = 255;
+			if (blue < 0) blue = 0;
+			uint16_t color = RGB565(blue);
+
+			int overlay_h = h * g_car.damage / GAME_OVER_DAMAGE / 2;
+			overlay_add_rect(&damage_layer, 0, 0, w, overlay_h + 1, color);
+			overlay_add_rect(&damage_layer, 0, h - overlay_h, w, overlay_h, color);
+		}
+		overlay_draw(&damage_layer, dl);
+	}
+
+	uint32_t score_key = (uint32_t)flip_indicator << 24 ^ (uint32_t)score;
+	if (overlay_begin(&score_layer, dl, score_key)) {
+		GfxRect bounds = {w / 2 - 8 * FONT_W, h * 15 / 16 - FONT_H, w / 2 + 8 * FONT_W, h * 15 / 16};
+		overlay_add_drawing(&score_layer, bounds, draw_score);
+	}
+	overlay_draw(&score_layer, dl);
 
 	if (g_is_paused) {
-		draw_pause_screen();
+		if (overlay_begin(&pause_layer, dl, 0)) {
+			overlay_add_drawing(&pause_layer, (GfxRect){0, 0, w, h}, draw_pause_screen);
+		}
+		overlay_draw(&pause_layer, dl);
 	}
 
 	#ifdef DEBUG_SHOW_FPS
-		char str[16];
-		sprintf(str, "FPS: %d, dt: %d", fps, last_tick_time);
-		draw_text(&screen_context, str, 0, debug_text_offset, RGB565(0xffffff), ANCHOR_TOP | ANCHOR_LEFT);
+		char str[32];
+		sprintf(str, "FPS: %d, dt: %d, q%d", fps, last_tick_time, quality_level());
+		dl_text(dl, str, 0, debug_text_offset, RGB565(0xffffff), ANCHOR_TOP | ANCHOR_LEFT);
+		debug_text_offset += FONT_H;
+	#endif
+
+	#ifdef DEBUG_SHOW_RENDER_STATS
+		char stats_str[32];
+		sprintf(stats_str, "seg %d/%d", render_stats.segments_drawn, render_stats.segments_drawn + render_stats.segments_culled);
+		dl_text(dl, stats_str, 0, debug_text_offset, RGB565(0xffffff), ANCHOR_TOP | ANCHOR_LEFT);
+		debug_text_offset += FONT_H;
+		sprintf(stats_str, "body %d/%d", render_stats.bodies_drawn, render_stats.bodies_drawn + render_stats.bodies_culled);
+		dl_text(dl, stats_str, 0, debug_text_offset, RGB565(0xffffff), ANCHOR_TOP | ANCHOR_LEFT);
 		debug_text_offset += FONT_H;
 	#endif
 }
 
-void draw_body(b2BodyId bodyId)
+static void draw_body(DrawList* dl, b2BodyId bodyId)
 {
-	b2Transform transform = b2Body_GetTransform(bodyId);
+	b2Transform transform = body_render_transform(bodyId);
 	BodyData* data = (BodyData*)b2Body_GetUserData(bodyId);
 
 	uint32_t fill_color = 0xffffff; // defaults
@@ -312,6 +487,10 @@ void draw_body(b2BodyId bodyId)
 		}
 	}
 
+	if (!g_quality->outlines) {
+		stroke_color = NO_COLOR;
+	}
+
 	int shape_count = b2Body_GetShapeCount(bodyId);
 	if (shape_count == 0) return;
 
@@ -330,51 +509,198 @@ void draw_body(b2BodyId bodyId)
 			}
 
 			if (fill_color != NO_COLOR) {
-				fill_polygon(&screen_context, screen_verts, polygon.count, RGB565(fill_color));
+				dl_polygon(dl, screen_verts, polygon.count, RGB565(fill_color));
 			}
 			if (stroke_color != NO_COLOR) {
-				draw_polygon(&screen_context, screen_verts, polygon.count, 0.15f * PIXELS_PER_METER, RGB565(stroke_color));
+				dl_polygon_outline(dl, screen_verts, polygon.count, camera_length(&camera, 15), RGB565(stroke_color));
 			}
 		} else if (type == b2_circleShape) {
 			b2Circle circle = b2Shape_GetCircle(shapeId);
 			vec2d p = world_to_screen(b2TransformPoint(transform, circle.center));
-			int r = circle.radius * PIXELS_PER_METER;
+			int r = camera_length(&camera, circle.radius * WORLD_SCALE);
 			if (fill_color != NO_COLOR) {
-				draw_solid_circle(&screen_context, p.x, p.y, r, RGB565(fill_color));
+				dl_solid_circle(dl, p.x, p.y, r, RGB565(fill_color));
 			}
 			if (stroke_color != NO_COLOR) {
-				draw_circle(&screen_context, p.x, p.y, r, 0.07f * PIXELS_PER_METER, RGB565(stroke_color));
+				dl_circle(dl, p.x, p.y, r, camera_length(&camera, 7), RGB565(stroke_color));
 			}
 		} else if (type == b2_chainSegmentShape) {
 			b2ChainSegment chain_segment = b2Shape_GetChainSegment(shapeId);
 			vec2d p1 = world_to_screen(b2TransformPoint(transform, chain_segment.segment.point1));
 			vec2d p2 = world_to_screen(b2TransformPoint(transform, chain_segment.segment.point2));
 			if (p1.x == p2.x && p1.y == p2.y) continue;
-			draw_line(&screen_context, p1.x, p1.y, p2.x, p2.y, 0.2f * PIXELS_PER_METER, RGB565(fill_color));
+			int thickness = g_quality->thick_lines ? camera_length(&camera, 20) : 1;
+			dl_line(dl, p1.x, p1.y, p2.x, p2.y, thickness, RGB565(fill_color));
+		}
+	}
+}
+
+static void draw_landscape(DrawList* dl, const BodyNode* node)
+{
+	uint16_t color = RGB565(0x4444ff);
+	int thickness = g_quality->thick_lines ? camera_length(&camera, 20) : 1;
+
+	const vec2d* points = node->points;
+	bool have_p1 = false;
+	vec2d p1 = {0, 0};
+	for (int i = 1; i < node->point_count; ++i) {
+		vec2d a = points[i - 1];
+		vec2d b = points[i];
+		if (box_outside_view(a.x < b.x ? a.x : b.x, a.y < b.y ? a.y : b.y, a.x < b.x ? b.x : a.x, a.y < b.y ? b.y : a.y)) {
+			render_stats.segments_culled++;
+			have_p1 = false;
+			continue;
 		}
+
+		if (!have_p1) {
+			p1 = camera_point(&camera, a);
+			have_p1 = true;
+		}
+		vec2d p2 = camera_point(&camera, b);
+		if (p1.x == p2.x && p1.y == p2.y) continue;
+		dl_line(dl, p1.x, p1.y, p2.x, p2.y, thickness, color);
+		render_stats.segments_drawn++;
+		p1 = p2;
 	}
 }
 
-static void draw_car_wheels(void)
+// Lowers the column tops under a ground segment, in screen coordinates,
+// to its surface plus `inset`.
+static void ground_add_segment(vec2d a, vec2d b, int inset)
+{
+	if (a.x > b.x) {
+		vec2d temp = a;
+		a = b;
+		b = temp;
+	}
+	int x0 = a.x < 0 ? 0 : a.x;
+	int x1 = b.x >= screen_width ? screen_width - 1 : b.x;
+	for (int x = x0; x <= x1; x++) {
+		int y;
+		if (a.x == b.x) {
+			y = a.y < b.y ? a.y : b.y;
+		} else {
+			y = a.y + (int)((int64_t)(b.y - a.y) * (x - a.x) / (b.x - a.x));
+		}
+		y += inset;
+		if (y < 0) y = 0;
+		if (y < ground_tops[x]) ground_tops[x] = y;
+	}
+}
+
+// Solid ground: the topmost ground surface of every column is found from
+// the segments in view horizontally, including ones above the screen,
+// then each column is filled from there down in one command. Floating
+// terrain doesn't count, and columns over a gap stay empty. The fill
+// starts below the terrain line to stay clear of it.
+static void draw_ground_fill(DrawList* dl, int line_thickness)
+{
+	if (ground_tops_size < screen_width) {
+		int16_t* tops = (int16_t*)realloc(ground_tops, screen_width * sizeof(int16_t));
+		if (!tops) return;
+		ground_tops = tops;
+		ground_tops_size = screen_width;
+	}
+	for (int x = 0; x < screen_width; x++) {
+		ground_tops[x] = screen_height;
+	}
+
+	bool any = false;
+	int first, end;
+	worldgen_landscape_range(view_min_x, view_max_x, &first, &end);
+	for (int n = first; n < end; n++) {
+		const BodyNode* node = worldgen_landscape(n);
+		if (!node->points || node->terrain != TERRAIN_GROUND ||
+		    node->max_x < view_min_x || node->min_y > view_max_y) {
+			continue;
+		}
+		for (int i = 1; i < node->point_count; i++) {
+			vec2d a = node->points[i - 1];
+			vec2d b = node->points[i];
+			if ((a.x > b.x ? a.x : b.x) < view_min_x || (a.x < b.x ? a.x : b.x) > view_max_x ||
+			    (a.y < b.y ? a.y : b.y) > view_max_y) {
+				continue;
+			}
+			ground_add_segment(camera_point(&camera, a), camera_point(&camera, b), line_thickness / 2);
+			any = true;
+		}
+	}
+
+	if (any) {
+		drawlist_set_layer(dl, DL_LAYER_GROUND);
+		dl_columns(dl, 0, ground_tops, screen_width, RGB565(GROUND_FILL_COLOR));
+	}
+}
+
+static bool body_outside_view(const BodyNode* node)
+{
+	if (node->type == BODY_TYPE_LANDSCAPE) {
+		return box_outside_view(node->min_x, node->min_y, node->max_x, node->max_y);
+	}
+	b2AABB aabb = b2Body_ComputeAABB(node->bodyId);
+	return box_outside_view(floorf(aabb.lowerBound.x * WORLD_SCALE), floorf(aabb.lowerBound.y * WORLD_SCALE),
+	                        ceilf(aabb.upperBound.x * WORLD_SCALE), ceilf(aabb.upperBound.y * WORLD_SCALE));
+}
+
+static void draw_car_wheels(DrawList* dl)
 {
 	if (b2Body_IsValid(g_car.leftWheel)) {
-		draw_body(g_car.leftWheel);
+		draw_body(dl, g_car.leftWheel);
 	}
 	if (b2Body_IsValid(g_car.rightWheel)) {
-		draw_body(g_car.rightWheel);
+		draw_body(dl, g_car.rightWheel);
 	}
 }
 
-static void draw_bodies(void)
+// Terrain goes to its own unordered layer, so the backend can batch it
+// regardless of where the car sits in the body list.
+static void draw_bodies(DrawList* dl)
 {
-	BodyNode* current = g_world.body_list;
-	while(current != NULL) {
-		if (b2Body_IsValid(current->bodyId)) {
-			draw_body(current->bodyId);
+	memset(&render_stats, 0, sizeof(render_stats));
+
+	if (g_fill_ground) {
+		draw_ground_fill(dl, g_quality->thick_lines ? camera_length(&camera, 20) : 1);
+	}
+
+	// landscape outside the horizontal range isn't looked at
+	int first, end;
+	worldgen_landscape_range(view_min_x, view_max_x, &first, &end);
+	render_stats.bodies_culled += worldgen_landscape_count() - (end - first);
+	for (int i = first; i < end; i++) {
+		const BodyNode* node = worldgen_landscape(i);
+		if (!b2Body_IsValid(node->bodyId)) {
+			continue;
+		}
+		if (body_outside_view(node)) {
+			render_stats.bodies_culled++;
+			render_stats.segments_culled += node->point_count > 0 ? node->point_count - 1 : 0;
+		} else {
+			render_stats.bodies_drawn++;
+			if (node->points) {
+				drawlist_set_layer(dl, DL_LAYER_TERRAIN);
+				draw_landscape(dl, node);
+			} else {
+				drawlist_set_layer(dl, DL_LAYER_BODIES);
+				draw_body(dl, node->bodyId);
+			}
 		}
-		current = current->next;
 	}
-	draw_car_wheels();
+
+	// newest first, as the old body list had it, then the wheels on top
+	drawlist_set_layer(dl, DL_LAYER_BODIES);
+	for (int i = worldgen_car_body_count() - 1; i >= 0; i--) {
+		const BodyNode* node = worldgen_car_body(i);
+		if (!b2Body_IsValid(node->bodyId)) {
+			continue;
+		}
+		if (body_outside_view(node)) {
+			render_stats.bodies_culled++;
+		} else {
+			render_stats.bodies_drawn++;
+			draw_body(dl, node->bodyId);
+		}
+	}
+	draw_car_wheels(dl);
 }
 
 void update_screen_size(int w, int h)
@@ -384,13 +710,47 @@ void update_screen_size(int w, int h)
 	screen_min_side = w > h ? h : w;
 }
 
+// counts drawn frames, skipped ones don't make the game smoother
+static void measure_fps(void)
+{
+	uint32_t current_time = sys_timer_ms();
+	last_tick_time = current_time - last_draw_time;
+	last_draw_time = current_time;
+
+	frame_count++;
+	if (current_time - fps_last_measured_time >= 1000) {
+		fps = frame_count;
+		frame_count = 0;
+		fps_last_measured_time = current_time;
+	}
+	if (!g_is_paused) {
+		quality_frame(last_tick_time);
+	}
+}
+
 void game_draw(GraphicsContext* ctx)
 {
-	clear(ctx);
+	measure_fps();
+
+	// nothing moves while paused, so the frame in the buffer stays valid
+	if (g_is_paused && paused_frame_shown && ctx->framebuf &&
+	    ctx->width == screen_width && ctx->height == screen_height) {
+		keep_frame(ctx);
+		return;
+	}
+
+	begin_frame(ctx);
 	update_screen_size(ctx->width, ctx->height);
 	update_camera();
-	draw_bodies();
-	game_draw_hud();
+
+	// full lists are flushed while drawing, count from the start
+	int failures = ctx->failures;
+	drawlist_begin(&g_draw_list, ctx);
+	draw_bodies(&g_draw_list);
+	game_draw_hud(&g_draw_list);
+	drawlist_execute(&g_draw_list, ctx);
+	draw_failures += ctx->failures - failures;
+	paused_frame_shown = g_is_paused;
 }
 
 void game_handle_keydown_default(void) { g_car.motor_on = true; }
@@ -413,11 +773,25 @@ void game_print_debug(void)
 	printf("\n");
 	printf("Car Pos: x=%d.%02dm, y=%d.%02dm", meters_x_int, meters_x_frac, meters_y_int, meters_y_frac);
 	printf(" (x=%du, y=%du)\n", pos_x_units, pos_y_units);
+	printf("Drawn: %d/%d bodies, %d/%d segments\n",
+		render_stats.bodies_drawn, render_stats.bodies_drawn + render_stats.bodies_culled,
+		render_stats.segments_drawn, render_stats.segments_drawn + render_stats.segments_culled);
+	printf("Quality tier %d: %d substeps, detail %d/%d\n", quality_level(),
+		g_quality->substeps, g_quality->detail, QUALITY_DETAIL_ONE);
+	worldgen_print_pool_usage();
+	printf("Draw list: %d commands, %d culled, %d merged, %d flushes, %d dropped\n",
+		g_draw_list.stats.commands, g_draw_list.stats.culled, g_draw_list.stats.merged,
+		g_draw_list.stats.flushes, g_draw_list.stats.dropped);
+	printf("Rasterizer: %d primitives skipped for lack of memory\n", draw_failures);
 }
 
+// For Box2D shapes: the offset from the camera is the only float math.
 vec2d world_to_screen(b2Vec2 worldPoint)
 {
-	int x = worldPoint.x * PIXELS_PER_METER + offset_x;
-	int y = worldPoint.y * PIXELS_PER_METER + offset_y;
-	return (vec2d){x, y};
+	int32_t dx = (worldPoint.x - camera.origin.x) * camera.unit_per_meter;
+	int32_t dy = (worldPoint.y - camera.origin.y) * camera.unit_per_meter;
+	return (vec2d){
+		(fix_mulw16(dx, camera.scale) + camera.anchor_x) >> 8,
+		(fix_mulw16(dy, camera.scale) + camera.anchor_y) >> 8
+	};
 }
@@ -2,12 +2,15 @@
 #define GAME_H
 
 #include "graphics.h"
+#include "drawlist.h"
 #include "game_types.h"
+#include "fixmath.h"
 
 #define WORLD_SCALE 100.0f  // 100.0 emini units = 1.0 Box2D meter
 
 // #define DEBUG_PIXELS_PER_METER 2.0f
 // #define DEBUG_SHOW_FPS
+// #define DEBUG_SHOW_RENDER_STATS
 
 #ifdef DEBUG_PIXELS_PER_METER
 	#define PIXELS_PER_METER (DEBUG_PIXELS_PER_METER)
@@ -16,14 +19,16 @@
 #endif
 
 extern bool g_is_paused;
-extern GraphicsContext screen_context;
+extern bool g_fill_ground;
 extern CarState g_car;
 extern WorldState g_world;
+extern DrawList g_draw_list;
 
 void game_init(void);
 void game_destroy(void);
 void game_update(int dt);
 void game_draw(GraphicsContext* ctx);
+void game_set_render_alpha(fix16 alpha);
 void update_screen_size(int w, int h);
 
 void game_handle_keydown_default(void);
@@ -3,6 +3,7 @@
 
 #include "box2d/id.h"
 #include "box2d/math_functions.h"
+#include "graphics.h"
 #include <stdbool.h>
 
 typedef enum {
@@ -12,6 +13,13 @@ typedef enum {
 	BODY_TYPE_LANDSCAPE,
 } BodyType;
 
+// What is under a piece of terrain: solid ground, or nothing because it
+// floats (platforms, the loop).
+typedef enum {
+	TERRAIN_GROUND,
+	TERRAIN_FLOATING,
+} TerrainKind;
+
 typedef struct {
 	BodyType type;
 } BodyData;
@@ -37,14 +45,23 @@ typedef struct BodyNode {
 	b2BodyId bodyId;
 	BodyType type;
 	float end_x;
-	struct BodyNode* next;
+	// Landscape only: render-side copy of the surface polyline in emini
+	// units and its bounds, so terrain is drawn without Box2D queries or
+	// float math.
+	vec2d* points;
+	int point_count;
+	int min_x, max_x;
+	int min_y, max_y;
+	TerrainKind terrain;
+	int reach_x; // largest max_x of this and all earlier landscape
 } BodyNode;
 
 typedef struct {
 	b2WorldId worldId;
-	BodyNode* body_list;
 	int last_x;
 	int last_y;
+	uint32_t seed;    // run seed the terrain follows from
+	uint32_t time_ms; // simulation time, advanced by each game_update()
 } WorldState;
 
 #endif
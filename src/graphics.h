@@ -2,17 +2,56 @@
 #define GRAPHICS_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <math.h>
 
+#include "palette.h"
+
 #define FONT_W 8
 #define FONT_H 16
 
+#define DAMAGE_MAX_RECTS 8
+
+/* x1, y1 are exclusive */
+typedef struct GfxRect {
+	int x0;
+	int y0;
+	int x1;
+	int y1;
+} GfxRect;
+
+typedef struct DamageList {
+	GfxRect rects[DAMAGE_MAX_RECTS];
+	int count;
+} DamageList;
+
 typedef struct GraphicsContext {
 	uint16_t* framebuf;
 	int width;
 	int height;
+	/* when set, primitives record what they touch so a frame only has to
+	 * clear those regions, and a display that takes a row window only has
+	 * to be sent their band */
+	bool track_damage;
+	DamageList damage;      /* drawn this frame */
+	DamageList prev_damage; /* drawn last frame */
+	bool unchanged;         /* frame kept as is, nothing to refresh */
+	/* indexed target: primitives write palette indices here instead of
+	 * framebuf and take indices for colors. expand_frame() brings the
+	 * regions to refresh over to framebuf as RGB565. */
+	uint8_t* indexbuf;
+	Palette* palette;
+	int failures; /* primitives skipped for lack of memory */
 } GraphicsContext;
 
+/* horizontal run of equally colored pixels */
+typedef struct ColorSpan {
+	int16_t x;
+	int16_t y;
+	uint16_t len;
+	uint16_t color;
+} ColorSpan;
+
 typedef struct vec2d {
 	int x;
 	int y;
@@ -27,17 +66,41 @@ enum Anchor {
 	ANCHOR_BOTTOM = 32
 };
 
+enum LineCap {
+	LINE_CAP_ROUND,
+	LINE_CAP_SQUARE,
+	LINE_CAP_BUTT
+};
+
 void clear(GraphicsContext* ctx);
+void begin_frame(GraphicsContext* ctx);
+void keep_frame(GraphicsContext* ctx);
+void damage_reset(GraphicsContext* ctx);
+int get_refresh_rects(const GraphicsContext* ctx, GfxRect* out, int max_count);
+/* sends rows [y0, y1) of ctx's frame to the display */
+typedef void (*RefreshFn)(GraphicsContext* ctx, int y0, int y1);
+/* Passes `push` the band of rows the display needs from `back` to show it
+ * in place of `front`, the frame it shows now (the same context when
+ * single buffered). Returns the rows in the band; 0 when nothing changed,
+ * and then `push` isn't called. */
+int refresh_display(GraphicsContext* back, const GraphicsContext* front, RefreshFn push);
+void add_damage(GraphicsContext* ctx, GfxRect rect);
+void expand_frame(GraphicsContext* ctx);
 void fill(GraphicsContext* ctx, uint16_t color);
 void draw_pixel(GraphicsContext* ctx, int x, int y, uint16_t color);
 
-void draw_line(GraphicsContext* ctx, int x0, int y0, int x1, int y1, float thickness, uint16_t color);
+void draw_line(GraphicsContext* ctx, int x0, int y0, int x1, int y1, int thickness, uint16_t color);
+void draw_line_capped(GraphicsContext* ctx, int x0, int y0, int x1, int y1, int thickness, int cap, uint16_t color);
+void draw_polyline(GraphicsContext* ctx, const vec2d* points, int count, int thickness, uint16_t color);
 void draw_hline(GraphicsContext* ctx, int x1, int x2, int y, uint16_t color);
 void fill_rect(GraphicsContext* ctx, int x, int y, int w, int h, uint16_t color);
-void draw_circle(GraphicsContext* ctx, int center_x, int center_y, int radius, float thickness, uint16_t color);
+void draw_spans(GraphicsContext* ctx, const ColorSpan* spans, int count);
+void draw_circle(GraphicsContext* ctx, int center_x, int center_y, int radius, int thickness, uint16_t color);
 void draw_solid_circle(GraphicsContext* ctx, int center_x, int center_y, int radius, uint16_t color);
-void draw_polygon(GraphicsContext* ctx, const vec2d* vertices, int vertexCount, float thickness, uint16_t color);
+void draw_polygon(GraphicsContext* ctx, const vec2d* vertices, int vertexCount, int thickness, uint16_t color);
 void fill_polygon(GraphicsContext* ctx, const vec2d* vertices, int vertexCount, uint16_t color);
+/* fills column x + i from tops[i] down to the bottom edge */
+void fill_columns(GraphicsContext* ctx, int x, const int16_t* tops, int count, uint16_t color);
 
 void draw_text(GraphicsContext* ctx, const char* text, int x, int y, uint16_t color, int anchor);
 
@@ -0,0 +1,121 @@
+#include "overlay.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+static bool add_span(OverlayLayer* layer, int x, int y, int len, uint16_t color)
+{
+	if (layer->span_count == layer->span_capacity) {
+		int capacity = layer->span_capacity ? layer->span_capacity * 2 : 64;
+		ColorSpan* spans = (ColorSpan*)realloc(layer->spans, capacity * sizeof(ColorSpan));
+		if (!spans) {
+			printf("overlay: out of memory\n");
+			layer->valid = false;
+			return false;
+		}
+		layer->spans = spans;
+		layer->span_capacity = capacity;
+	}
+	layer->spans[layer->span_count++] = (ColorSpan){x, y, len, color};
+	return true;
+}
+
+// Returns true when the caller has to (re)add the layer content.
+bool overlay_begin(OverlayLayer* layer, DrawList* list, uint32_t key)
+{
+	GraphicsContext* ctx = list->target;
+	layer->list = list;
+	if (!ctx->framebuf) {
+		layer->immediate = true;
+		layer->valid = false;
+		return true;
+	}
+	layer->immediate = false;
+
+	if (layer->valid && layer->key == key && layer->width == ctx->width && layer->height == ctx->height) {
+		return false;
+	}
+	layer->valid = true;
+	layer->key = key;
+	layer->width = ctx->width;
+	layer->height = ctx->height;
+	layer->span_count = 0;
+	return true;
+}
+
+void overlay_add_rect(OverlayLayer* layer, int x, int y, int w, int h, uint16_t color)
+{
+	if (layer->immediate) {
+		dl_rect(layer->list, x, y, w, h, color);
+		return;
+	}
+
+	int x0 = x < 0 ? 0 : x;
+	int y0 = y < 0 ? 0 : y;
+	int x1 = x + w > layer->width ? layer->width : x + w;
+	int y1 = y + h > layer->height ? layer->height : y + h;
+
+	for (int j = y0; j < y1 && x0 < x1; j++) {
+		if (!add_span(layer, x0, j, x1 - x0, color)) return;
+	}
+}
+
+// Renders `draw` into a scratch buffer covering `bounds` and keeps the
+// non-transparent pixels as spans.
+void overlay_add_drawing(OverlayLayer* layer, GfxRect bounds, OverlayDrawFn draw)
+{
+	if (layer->immediate) {
+		draw(layer->list, 0, 0);
+		return;
+	}
+
+	if (bounds.x0 < 0) bounds.x0 = 0;
+	if (bounds.y0 < 0) bounds.y0 = 0;
+	if (bounds.x1 > layer->width) bounds.x1 = layer->width;
+	if (bounds.y1 > layer->height) bounds.y1 = layer->height;
+	if (bounds.x0 >= bounds.x1 || bounds.y0 >= bounds.y1) return;
+
+	GraphicsContext scratch = {0};
+	scratch.width = bounds.x1 - bounds.x0;
+	scratch.height = bounds.y1 - bounds.y0;
+	scratch.framebuf = (uint16_t*)malloc(scratch.width * scratch.height * sizeof(uint16_t));
+	if (!scratch.framebuf) {
+		printf("overlay: out of memory\n");
+		layer->valid = false;
+		return;
+	}
+
+	fill(&scratch, OVERLAY_KEY_COLOR);
+	drawlist_begin_capture(layer->list);
+	draw(layer->list, bounds.x0, bounds.y0);
+	drawlist_end_capture(layer->list, &scratch);
+
+	const uint16_t* row = scratch.framebuf;
+	for (int y = 0; y < scratch.height; y++, row += scratch.width) {
+		int x = 0;
+		while (x < scratch.width) {
+			uint16_t color = row[x];
+			int start = x;
+			while (x < scratch.width && row[x] == color) x++;
+			if (color != OVERLAY_KEY_COLOR && !add_span(layer, bounds.x0 + start, bounds.y0 + y, x - start, color)) {
+				free(scratch.framebuf);
+				return;
+			}
+		}
+	}
+	free(scratch.framebuf);
+}
+
+void overlay_draw(OverlayLayer* layer, DrawList* list)
+{
+	if (layer->immediate || !layer->valid) return;
+	dl_spans(list, layer->spans, layer->span_count);
+}
+
+void overlay_free(OverlayLayer* layer)
+{
+	free(layer->spans);
+	layer->spans = NULL;
+	layer->span_count = 0;
+	layer->span_capacity = 0;
+	layer->valid = false;
+}
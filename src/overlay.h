@@ -0,0 +1,35 @@
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include "graphics.h"
+#include "drawlist.h"
+
+// Pixels of this color are transparent while a layer is being built.
+// No HUD color maps to it.
+#define OVERLAY_KEY_COLOR 0x0020
+
+typedef void (*OverlayDrawFn)(DrawList* list, int origin_x, int origin_y);
+
+// Retained overlay: its content is kept as color spans and only rebuilt
+// when the key it was built for changes. Backends without a framebuffer
+// can't render offscreen, so there the layer content goes into the draw
+// list every frame.
+typedef struct {
+	ColorSpan* spans;
+	int span_count;
+	int span_capacity;
+	uint32_t key;
+	int width;
+	int height;
+	bool valid;
+	bool immediate;
+	DrawList* list;
+} OverlayLayer;
+
+bool overlay_begin(OverlayLayer* layer, DrawList* list, uint32_t key);
+void overlay_add_rect(OverlayLayer* layer, int x, int y, int w, int h, uint16_t color);
+void overlay_add_drawing(OverlayLayer* layer, GfxRect bounds, OverlayDrawFn draw);
+void overlay_draw(OverlayLayer* layer, DrawList* list);
+void overlay_free(OverlayLayer* layer);
+
+#endif
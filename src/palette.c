@@ -0,0 +1,66 @@
+#include "palette.h"
+#include <string.h>
+
+static int color_hash(uint16_t color)
+{
+	return (uint16_t)(color * 0x9e37u) >> 7 & (PALETTE_HASH_SIZE - 1);
+}
+
+// slot holding `color`, or the empty slot where it would go
+static int find_slot(const Palette* pal, uint16_t color)
+{
+	int slot = color_hash(color);
+	while (pal->slots[slot] && pal->colors[pal->slots[slot] - 1] != color) {
+		slot = (slot + 1) & (PALETTE_HASH_SIZE - 1);
+	}
+	return slot;
+}
+
+static uint8_t nearest(const Palette* pal, uint16_t color)
+{
+	int r = color >> 11, g = color >> 5 & 0x3f, b = color & 0x1f;
+	int best = 0;
+	int best_dist = -1;
+	for (int i = 0; i < pal->count; i++) {
+		uint16_t c = pal->colors[i];
+		int dr = (c >> 11) - r, dg = (c >> 5 & 0x3f) - g, db = (c & 0x1f) - b;
+		// green has twice the resolution
+		int dist = 4 * dr * dr + dg * dg + 4 * db * db;
+		if (best_dist < 0 || dist < best_dist) {
+			best = i;
+			best_dist = dist;
+		}
+	}
+	return best;
+}
+
+void palette_init(Palette* pal)
+{
+	memset(pal, 0, sizeof(*pal));
+	pal->colors[0] = 0;
+	pal->count = 1;
+	pal->slots[find_slot(pal, 0)] = 1;
+}
+
+uint8_t palette_add(Palette* pal, uint16_t color)
+{
+	int slot = find_slot(pal, color);
+	if (pal->slots[slot]) {
+		return pal->slots[slot] - 1;
+	}
+	if (pal->count == PALETTE_SIZE) {
+		return nearest(pal, color);
+	}
+	pal->colors[pal->count] = color;
+	pal->slots[slot] = ++pal->count;
+	return pal->count - 1;
+}
+
+uint8_t palette_find(const Palette* pal, uint16_t color)
+{
+	int slot = find_slot(pal, color);
+	if (pal->slots[slot]) {
+		return pal->slots[slot] - 1;
+	}
+	return nearest(pal, color);
+}
@@ -0,0 +1,28 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include <stdint.h>
+
+#define PALETTE_SIZE 256
+#define PALETTE_HASH_SIZE 512
+
+// Colors of an indexed render target. Entries are added as colors show
+// up and never removed, since pixels of earlier frames may still use them.
+// Index 0 is black, what begin_frame() clears to.
+typedef struct Palette {
+	uint16_t colors[PALETTE_SIZE];
+	int count;
+	uint16_t slots[PALETTE_HASH_SIZE]; // index + 1, 0 for an empty slot
+} Palette;
+
+void palette_init(Palette* pal);
+
+// Index of an RGB565 color, added if new. A full palette gives the
+// nearest entry instead.
+uint8_t palette_add(Palette* pal, uint16_t color);
+
+// Same result as palette_add() but never changes the palette, so it can
+// be called from several threads once the colors are added.
+uint8_t palette_find(const Palette* pal, uint16_t color);
+
+#endif
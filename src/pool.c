@@ -0,0 +1,146 @@
+#include "pool.h"
+#include <stdio.h>
+
+void pool_init(Pool* pool, void* storage, int item_size, int capacity, const char* name)
+{
+	// each free record holds the next pointer, a smaller stride would
+	// write past the storage
+	if (item_size < (int)sizeof(void*)) {
+		printf("%s pool: %d byte records can't hold a pointer, pool disabled\n", name, item_size);
+		capacity = 0;
+	}
+	pool->storage = (uint8_t*)storage;
+	pool->item_size = item_size;
+	pool->capacity = capacity;
+	pool->name = name;
+	pool->high_water = 0;
+	pool->failures = 0;
+	pool_reset(pool);
+}
+
+void* pool_acquire(Pool* pool)
+{
+	void* item;
+	if (pool->free_list) {
+		item = pool->free_list;
+		pool->free_list = *(void**)item;
+	} else if (pool->next_unused < pool->capacity) {
+		item = pool->storage + pool->next_unused++ * pool->item_size;
+	} else {
+		if (pool->failures++ == 0) {
+			printf("%s pool: all %d used\n", pool->name, pool->capacity);
+		}
+		return NULL;
+	}
+	if (++pool->used > pool->high_water) pool->high_water = pool->used;
+	return item;
+}
+
+void pool_release(Pool* pool, void* item)
+{
+	if (!item) return;
+	*(void**)item = pool->free_list;
+	pool->free_list = item;
+	pool->used--;
+}
+
+void pool_reset(Pool* pool)
+{
+	pool->free_list = NULL;
+	pool->next_unused = 0;
+	pool->used = 0;
+}
+
+int pool_available(const Pool* pool)
+{
+	return pool->capacity - pool->used;
+}
+
+// Every block starts with its size, including the header, rounded to 8.
+// The low bit marks released blocks and the filler that skips the end of
+// the buffer when a block doesn't fit there.
+#define RING_HEADER 8
+#define RING_RELEASED 1
+
+static int32_t* block_header(RingArena* ring, int offset)
+{
+	return (int32_t*)(ring->buf + offset);
+}
+
+void ring_init(RingArena* ring, void* buf, int size, const char* name)
+{
+	ring->buf = (uint8_t*)buf;
+	ring->size = size & ~7;
+	ring->name = name;
+	ring->high_water = 0;
+	ring->failures = 0;
+	ring_reset(ring);
+}
+
+void ring_reset(RingArena* ring)
+{
+	ring->head = 0;
+	ring->tail = 0;
+	ring->count = 0;
+	ring->used = 0;
+}
+
+void* ring_alloc(RingArena* ring, int bytes)
+{
+	int need = (bytes + RING_HEADER + 7) & ~7;
+	int offset = -1;
+
+	if (ring->count == 0) {
+		ring->head = ring->tail = 0;
+	}
+	if (ring->head > ring->tail || ring->count == 0) {
+		// live blocks in [tail, head), free space at the end and before tail
+		if (ring->size - ring->head >= need) {
+			offset = ring->head;
+		} else if (need <= ring->tail) {
+			if (ring->head < ring->size) {
+				*block_header(ring, ring->head) = (ring->size - ring->head) | RING_RELEASED;
+			}
+			offset = 0;
+		}
+	} else if (ring->tail - ring->head >= need) {
+		offset = ring->head;
+	}
+
+	if (offset < 0) {
+		if (ring->failures++ == 0) {
+			printf("%s ring: %d of %d bytes used, %d more needed\n", ring->name, ring->used, ring->size, need);
+		}
+		return NULL;
+	}
+
+	*block_header(ring, offset) = need;
+	ring->head = offset + need;
+	ring->count++;
+	ring->used += need;
+	if (ring->used > ring->high_water) ring->high_water = ring->used;
+	return ring->buf + offset + RING_HEADER;
+}
+
+void ring_release(RingArena* ring, void* block)
+{
+	if (!block) return;
+	int32_t* header = (int32_t*)((uint8_t*)block - RING_HEADER);
+	ring->used -= *header;
+	*header |= RING_RELEASED;
+	ring->count--;
+
+	// a live block is left as long as count > 0, so this stops
+	while (ring->count > 0) {
+		if (ring->tail == ring->size) {
+			ring->tail = 0;
+			continue;
+		}
+		int32_t h = *block_header(ring, ring->tail);
+		if (!(h & RING_RELEASED)) break;
+		ring->tail += h & ~RING_RELEASED;
+	}
+	if (ring->count == 0) {
+		ring->head = ring->tail = 0;
+	}
+}
@@ -0,0 +1,47 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Fixed-size records from caller-provided storage. Released records go on
+// a free list; records never handed out are taken from a bump index, so
+// a reset only rewinds both. A record must be able to hold a pointer.
+typedef struct Pool {
+	uint8_t* storage;
+	int item_size;
+	int capacity;
+	void* free_list;
+	int next_unused;
+	int used;
+	int high_water;
+	int failures;
+	const char* name;
+} Pool;
+
+void pool_init(Pool* pool, void* storage, int item_size, int capacity, const char* name);
+void* pool_acquire(Pool* pool); // NULL when exhausted
+void pool_release(Pool* pool, void* item);
+void pool_reset(Pool* pool);
+int pool_available(const Pool* pool);
+
+// Variable-size blocks allocated in FIFO order from a ring buffer. A block
+// released out of order is reclaimed once everything older is released.
+typedef struct RingArena {
+	uint8_t* buf;
+	int size;
+	int head;  // where the next block goes
+	int tail;  // oldest block still in the ring
+	int count; // live blocks
+	int used;  // bytes in live blocks
+	int high_water;
+	int failures;
+	const char* name;
+} RingArena;
+
+void ring_init(RingArena* ring, void* buf, int size, const char* name);
+void* ring_alloc(RingArena* ring, int bytes); // NULL when full
+void ring_release(RingArena* ring, void* block);
+void ring_reset(RingArena* ring);
+
+#endif
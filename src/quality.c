@@ -0,0 +1,80 @@
+#include "quality.h"
+
+#define DEFAULT_LEVEL 3
+
+static const QualityTier tiers[QUALITY_TIER_COUNT] = {
+	// substeps, detail, thick lines, outlines, hud effects
+	{2, 2, false, false, false},
+	{4, 3, false, true,  false},
+	{4, 4, true,  true,  true },
+	{8, 4, true,  true,  true }, // what the game always ran at
+	{8, 6, true,  true,  true },
+};
+
+// frame times are averaged in 1/16 ms with a weight of 1/8
+#define AVG_ONE 16
+#define AVG_WEIGHT 8
+
+// the gap between the two thresholds and the longer hold for going up
+// keep the tier from flipping back and forth around the target
+#define DOWN_THRESHOLD (QUALITY_TARGET_MS * AVG_ONE * 5 / 4)
+#define UP_THRESHOLD (QUALITY_TARGET_MS * AVG_ONE * 3 / 4)
+#define DOWN_HOLD_FRAMES 15
+#define UP_HOLD_FRAMES 90
+#define MAX_UP_HOLD_FRAMES (UP_HOLD_FRAMES * 8)
+// stepping down this soon after stepping up makes the next try wait longer
+#define RETRY_WINDOW_FRAMES 300
+
+const QualityTier* g_quality = &tiers[DEFAULT_LEVEL];
+
+static int level = DEFAULT_LEVEL;
+static int avg = QUALITY_TARGET_MS * AVG_ONE;
+static int slow_frames;
+static int fast_frames;
+static int up_hold = UP_HOLD_FRAMES;
+static int since_up = -1;
+static bool locked;
+
+void quality_set_level(int new_level)
+{
+	if (new_level < 0) new_level = 0;
+	if (new_level > QUALITY_TIER_COUNT - 1) new_level = QUALITY_TIER_COUNT - 1;
+	level = new_level;
+	g_quality = &tiers[level];
+	avg = QUALITY_TARGET_MS * AVG_ONE;
+	slow_frames = 0;
+	fast_frames = 0;
+}
+
+void quality_lock(bool lock)
+{
+	locked = lock;
+}
+
+int quality_level(void)
+{
+	return level;
+}
+
+void quality_frame(int frame_ms)
+{
+	if (locked) return;
+	if (frame_ms < 0) frame_ms = 0;
+	if (frame_ms > 250) frame_ms = 250;
+	avg += (frame_ms * AVG_ONE - avg) / AVG_WEIGHT;
+	if (since_up >= 0) since_up++;
+
+	slow_frames = avg > DOWN_THRESHOLD ? slow_frames + 1 : 0;
+	fast_frames = avg < UP_THRESHOLD ? fast_frames + 1 : 0;
+
+	if (slow_frames >= DOWN_HOLD_FRAMES && level > 0) {
+		if (since_up >= 0 && since_up < RETRY_WINDOW_FRAMES && up_hold < MAX_UP_HOLD_FRAMES) {
+			up_hold *= 2;
+		}
+		since_up = -1;
+		quality_set_level(level - 1);
+	} else if (fast_frames >= up_hold && level < QUALITY_TIER_COUNT - 1) {
+		since_up = 0;
+		quality_set_level(level + 1);
+	}
+}
@@ -0,0 +1,35 @@
+#ifndef QUALITY_H
+#define QUALITY_H
+
+#include <stdbool.h>
+
+// frame time the governor aims for, the fp loop never goes below 16 ms
+#ifndef QUALITY_TARGET_MS
+#define QUALITY_TARGET_MS 33
+#endif
+
+// terrain detail is in these units, so 4 is the old DETAIL_LEVEL 1
+#define QUALITY_DETAIL_ONE 4
+
+typedef struct {
+	int substeps;      // Box2D sub-steps per physics step
+	int detail;        // tessellation of newly generated terrain
+	bool thick_lines;  // terrain drawn at its world thickness, else 1 px
+	bool outlines;     // car outlines
+	bool hud_effects;  // damage tint
+} QualityTier;
+
+#define QUALITY_TIER_COUNT 5
+
+extern const QualityTier* g_quality;
+
+// Feeds the time between two drawn frames. Slower than the target for a
+// while steps down a tier, faster for longer steps up.
+void quality_frame(int frame_ms);
+int quality_level(void);
+void quality_set_level(int level);
+// Keeps the governor from changing the tier, the tier decides physics
+// sub-steps and terrain detail, so recorded runs need it fixed.
+void quality_lock(bool lock);
+
+#endif
@@ -0,0 +1,222 @@
+#include "replay.h"
+#include "game.h"
+#include "worldgen.h"
+#include "quality.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// File layout, little-endian:
+//   "FPBX", version, quality tier, step ms (16 bits), seed (32), ticks (32)
+// then one varint per input: the ticks since the previous input, shifted
+// left by two, with the input in the low bits. A player holding the gas
+// costs a byte or two per press.
+#define REPLAY_MAGIC "FPBX"
+#define REPLAY_VERSION 1
+#define REPLAY_HEADER 16
+#define INPUT_BITS 2
+
+static ReplayMode mode;
+static uint8_t* data;
+static int size;
+static int capacity;
+static int read_pos;
+static uint32_t tick;
+static uint32_t last_tick;  // of the previous input
+static uint32_t total_ticks;
+static uint32_t next_tick;  // when playing, of the input at read_pos
+static int next_input = -1;
+static int step_ms;
+
+static void apply(ReplayInput input)
+{
+	switch (input) {
+	case INPUT_GAS_DOWN: game_handle_keydown_default(); break;
+	case INPUT_GAS_UP: game_handle_keyup_default(); break;
+	case INPUT_RESTART: game_init(); break;
+	default: break;
+	}
+}
+
+static bool reserve(int bytes)
+{
+	if (bytes <= capacity) return true;
+	int new_capacity = capacity ? capacity : 256;
+	while (new_capacity < bytes) new_capacity *= 2;
+	uint8_t* grown = realloc(data, new_capacity);
+	if (!grown) return false;
+	data = grown;
+	capacity = new_capacity;
+	return true;
+}
+
+static void append(const uint8_t* bytes, int count)
+{
+	if (!reserve(size + count)) {
+		printf("Replay: out of memory, recording stopped\n");
+		replay_stop();
+		return;
+	}
+	memcpy(data + size, bytes, count);
+	size += count;
+}
+
+static void put_u32(uint8_t* p, uint32_t v)
+{
+	for (int i = 0; i < 4; i++) p[i] = v >> (8 * i);
+}
+
+static uint32_t get_u32(const uint8_t* p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// decodes the next input into next_tick and next_input, -1 at the end
+static void read_next(void)
+{
+	uint32_t v = 0;
+	int shift = 0;
+	next_input = -1;
+	while (read_pos < size && shift < 32) {
+		uint8_t b = data[read_pos++];
+		v |= (uint32_t)(b & 0x7f) << shift;
+		shift += 7;
+		if (!(b & 0x80)) {
+			next_tick = last_tick + (v >> INPUT_BITS);
+			next_input = v & ((1 << INPUT_BITS) - 1);
+			last_tick = next_tick;
+			return;
+		}
+	}
+}
+
+void replay_input(ReplayInput input)
+{
+	if (mode == REPLAY_PLAYING) return;
+	if (mode == REPLAY_RECORDING) {
+		uint8_t bytes[5];
+		int n = 0;
+		uint32_t v = (tick - last_tick) << INPUT_BITS | input;
+		for (; v >= 0x80; v >>= 7) {
+			bytes[n++] = v | 0x80;
+		}
+		bytes[n++] = v;
+		append(bytes, n);
+		last_tick = tick;
+	}
+	apply(input);
+}
+
+void replay_step(int dt)
+{
+	if (mode == REPLAY_PLAYING) {
+		while (next_input >= 0 && next_tick == tick) {
+			apply(next_input);
+			read_next();
+		}
+	}
+	game_update(dt);
+	tick++;
+}
+
+static void start(ReplayMode new_mode)
+{
+	mode = new_mode;
+	tick = 0;
+	last_tick = 0;
+	quality_lock(true);
+}
+
+void replay_record(int step)
+{
+	static const uint8_t header[REPLAY_HEADER];
+	replay_stop();
+	size = 0;
+	step_ms = step;
+	start(REPLAY_RECORDING);
+	append(header, REPLAY_HEADER);
+}
+
+bool replay_save(const char* path)
+{
+	if (size < REPLAY_HEADER) return false;
+	memcpy(data, REPLAY_MAGIC, 4);
+	data[4] = REPLAY_VERSION;
+	data[5] = quality_level();
+	data[6] = step_ms;
+	data[7] = step_ms >> 8;
+	put_u32(data + 8, g_world.seed);
+	put_u32(data + 12, mode == REPLAY_RECORDING ? tick : total_ticks);
+
+	FILE* f = fopen(path, "wb");
+	if (!f) {
+		printf("Replay: cannot write %s\n", path);
+		return false;
+	}
+	bool ok = fwrite(data, 1, size, f) == (size_t)size;
+	ok = fclose(f) == 0 && ok;
+	if (ok) {
+		printf("Replay: %u ticks, %d bytes of input saved to %s\n", (unsigned)get_u32(data + 12), size - REPLAY_HEADER, path);
+	}
+	return ok;
+}
+
+bool replay_play(const char* path)
+{
+	replay_stop();
+	FILE* f = fopen(path, "rb");
+	if (!f) {
+		printf("Replay: cannot read %s\n", path);
+		return false;
+	}
+	fseek(f, 0, SEEK_END);
+	long length = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	size = 0;
+	if (length > 0 && length < INT32_MAX && reserve(length)) {
+		size = fread(data, 1, length, f);
+	}
+	fclose(f);
+	if (size < REPLAY_HEADER || memcmp(data, REPLAY_MAGIC, 4) || data[4] != REPLAY_VERSION) {
+		printf("Replay: %s is not a recording\n", path);
+		size = 0;
+		return false;
+	}
+
+	step_ms = data[6] | data[7] << 8;
+	total_ticks = get_u32(data + 12);
+	quality_set_level(data[5]);
+	worldgen_seed(get_u32(data + 8));
+	start(REPLAY_PLAYING);
+	read_pos = REPLAY_HEADER;
+	read_next();
+	return true;
+}
+
+void replay_stop(void)
+{
+	if (mode == REPLAY_RECORDING) total_ticks = tick;
+	if (mode != REPLAY_OFF) quality_lock(false);
+	mode = REPLAY_OFF;
+	next_input = -1;
+}
+
+ReplayMode replay_mode(void)
+{
+	return mode;
+}
+
+int replay_step_ms(void)
+{
+	return step_ms;
+}
+
+uint32_t replay_ticks(void)
+{
+	return mode == REPLAY_PLAYING ? total_ticks : tick;
+}
+
+bool replay_finished(void)
+{
+	return mode == REPLAY_PLAYING && tick >= total_ticks;
+}
@@ -0,0 +1,43 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Inputs that change the simulation. Platforms pass them through
+// replay_input() so a run can be recorded and played back exactly.
+typedef enum {
+	INPUT_GAS_DOWN,
+	INPUT_GAS_UP,
+	INPUT_RESTART,
+	INPUT_COUNT
+} ReplayInput;
+
+typedef enum {
+	REPLAY_OFF,
+	REPLAY_RECORDING,
+	REPLAY_PLAYING
+} ReplayMode;
+
+// Applies a live input, it takes effect from the next tick on. Ignored
+// while a recording plays.
+void replay_input(ReplayInput input);
+
+// Scheduler step: applies the recorded inputs due before this tick when
+// playing, then runs game_update().
+void replay_step(int dt);
+
+// Both start from the next tick and lock the quality tier, so call them
+// right before game_init(). Recording stores the run seed, the step and
+// the tier; playing restores them.
+void replay_record(int step_ms);
+bool replay_play(const char* path);
+bool replay_save(const char* path);
+void replay_stop(void);
+
+ReplayMode replay_mode(void);
+int replay_step_ms(void);      // of the recording being played
+uint32_t replay_ticks(void);   // run so far, or recorded when playing
+bool replay_finished(void);    // played up to the last recorded tick
+
+#endif
@@ -0,0 +1,52 @@
+#include "scheduler.h"
+
+void scheduler_init(Scheduler* s, int step_ms, int max_steps, int max_skip)
+{
+	s->step_ms = step_ms > 0 ? step_ms : 1;
+	s->max_steps = max_steps > 0 ? max_steps : 1;
+	s->max_skip = max_skip;
+	s->accumulator = 0;
+	s->skipped = 0;
+	s->steps = 0;
+	s->dropped_ms = 0;
+	s->skipped_total = 0;
+}
+
+bool scheduler_run(Scheduler* s, int elapsed_ms, SchedulerStepFn step)
+{
+	if (elapsed_ms < 0) elapsed_ms = 0;
+	s->accumulator += elapsed_ms;
+
+	int steps = s->accumulator / s->step_ms;
+	// drawing is what made us fall behind: give its time to the steps
+	// still pending, at most max_skip frames in a row
+	bool skip = steps > s->max_steps && s->skipped < s->max_skip;
+	if (steps > s->max_steps) {
+		steps = s->max_steps;
+	}
+
+	for (int i = 0; i < steps; i++) {
+		step(s->step_ms);
+	}
+	s->accumulator -= steps * s->step_ms;
+	s->steps = steps;
+
+	if (skip) {
+		s->skipped++;
+		s->skipped_total++;
+		return false;
+	}
+	if (s->accumulator >= s->step_ms) {
+		// out of skips: steps stay the same length, the extra time is lost
+		int keep = s->accumulator % s->step_ms;
+		s->dropped_ms += s->accumulator - keep;
+		s->accumulator = keep;
+	}
+	s->skipped = 0;
+	return true;
+}
+
+fix16 scheduler_alpha(const Scheduler* s)
+{
+	return (fix16)(((int64_t)s->accumulator << FIX16_SHIFT) / s->step_ms);
+}
@@ -0,0 +1,50 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fixmath.h"
+
+#ifndef PHYSICS_STEP_MS
+#define PHYSICS_STEP_MS 16
+#endif
+
+// a slower frame than this many steps runs the game in slow motion
+#ifndef MAX_STEPS_PER_FRAME
+#define MAX_STEPS_PER_FRAME 4
+#endif
+
+// frames in a row that may go undrawn while catching up
+#ifndef MAX_FRAME_SKIP
+#define MAX_FRAME_SKIP 2
+#endif
+
+typedef void (*SchedulerStepFn)(int dt);
+
+// Fixed timestep: frame time goes into an accumulator and the game is
+// stepped in whole `step_ms` steps. What is left over is the fraction of
+// a step drawing should interpolate by.
+typedef struct {
+	int step_ms;
+	int max_steps;
+	int max_skip;
+	int accumulator;
+	int skipped;     // frames in a row not drawn
+	int steps;       // run by the last scheduler_run()
+	int dropped_ms;  // total time thrown away at the step cap
+	int skipped_total;
+} Scheduler;
+
+void scheduler_init(Scheduler* s, int step_ms, int max_steps, int max_skip);
+
+// Runs the steps `elapsed_ms` of frame time is worth, at most max_steps.
+// Returns false when steps are still pending and this frame should not be
+// drawn. After max_skip such frames in a row the pending time is dropped
+// and the frame is drawn.
+bool scheduler_run(Scheduler* s, int elapsed_ms, SchedulerStepFn step);
+
+// how far past the last step the frame is, [0, 1) in Q16.16
+fix16 scheduler_alpha(const Scheduler* s);
+
+#endif
@@ -1,7 +1,7 @@
 #include "structure_placer.h"
 #include "element_placer.h"
 #include "worldgen.h"
-#include <math.h>
+#include "fixmath.h"
 
 EndPoint place_arc1_struct(int x, int y, int r)
 {
@@ -10,10 +10,12 @@ EndPoint place_arc1_struct(int x, int y, int r)
 
 	place_arc(cursor_x - r, y - r2, r2, 60, 30);
 
+	// the loop hangs over the hill formed by the other two arcs
+	world_set_terrain_kind(TERRAIN_FLOATING);
 	place_arc(cursor_x + r/2, y - r*2, r, 300, 120);
+	world_set_terrain_kind(TERRAIN_GROUND);
 
-	float cos30 = cosf(30.0f * M_PI / 180.0f);
-	int offset = (1 - cos30) * 2 * r2;
+	int offset = (int)((int64_t)(FIX16_ONE - fix_cos_deg(30)) * 2 * r2 >> FIX16_SHIFT);
 	place_arc(cursor_x + r*2 - offset, y - r2, r2, 60, 90);
 
 	int l = r2 + r2 - offset;
@@ -25,7 +27,7 @@ EndPoint place_sin_struct(int x, int y, int l, int half_periods, int offset, int
 {
 	place_sin(x, y, l, half_periods, offset, amp);
 
-	return (EndPoint){x + l, y + amp * sinf(M_PI * (offset + 180 * half_periods) / 180.0f)};
+	return (EndPoint){x + l, y + amp * fix_sin_deg(offset + 180 * half_periods) / FIX16_ONE};
 }
 
 EndPoint place_horizontal_floor_struct(int x, int y, int l)
@@ -51,18 +53,23 @@ EndPoint place_abyss_struct(int x, int y, int l)
 	int ang = 60; // springboard angle
 	int r = l / 8;
 	place_scaled_arc(x, y-r, r, ang, 90 - ang, 15, 10);
-	place_line(x+l - l / 5, y - r * cosf(ang), x+l, y - r * cosf(ang));
+	// the landing height came from cosf(ang), which read the degrees as
+	// radians; 60 radians is about 198 degrees
+	int landing_dy = r * fix_cos_deg(198) / FIX16_ONE;
+	place_line(x+l - l / 5, y - landing_dy, x+l, y - landing_dy);
 	end_x += l;
-	y -= r * cosf(ang);
+	y -= landing_dy;
 	return (EndPoint){end_x, y};
 }
 
 EndPoint place_slanted_dotted_line_struct(int x, int y, int n)
 {
 	int offset_l = 600;
+	world_set_terrain_kind(TERRAIN_FLOATING);
 	for (int i = 0; i < n; i++) {
 		place_line(x + i*offset_l, y + i * 300/n, x + i*offset_l + 300, y + i * 300/n - 300);
 	}
+	world_set_terrain_kind(TERRAIN_GROUND);
 	return (EndPoint){x + n * offset_l, y};
 }
 
@@ -2,81 +2,569 @@
 #include "box2d/box2d.h"
 #include "game.h"
 #include "structure_placer.h"
+#include "element_placer.h"
+#include "pool.h"
+#include "quality.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 #include <math.h>
 
 int prev_structure_id = -1;
+static TerrainKind terrain_kind = TERRAIN_GROUND;
+
+// Body records and terrain render points come from fixed budgets instead
+// of the heap, so driving doesn't fragment it and a restart just rewinds
+// them.
+#ifndef WORLDGEN_MAX_BODIES
+#define WORLDGEN_MAX_BODIES 256
+#endif
+#ifndef WORLDGEN_POINT_BYTES
+#define WORLDGEN_POINT_BYTES (64 * 1024)
+#endif
+// enough for the largest structure
+#define STRUCTURE_MAX_ELEMENTS 16
+#define CAR_MAX_BODIES 4
+
+// Landscape is generated left to right, so it is kept in a ring sorted by
+// min_x: old pieces expire from the front, new ones go on the back, and
+// the pieces in view are found by binary search.
+static BodyNode landscape[WORLDGEN_MAX_BODIES];
+static int landscape_head;
+static int landscape_count;
+static int landscape_high_water;
+static BodyNode car_bodies[CAR_MAX_BODIES];
+static int car_body_count;
+
+// a free record holds the pool's next pointer
+static union {
+	BodyData data;
+	void* next;
+} data_storage[WORLDGEN_MAX_BODIES + CAR_MAX_BODIES];
+static uint64_t point_storage[WORLDGEN_POINT_BYTES / sizeof(uint64_t)];
+static Pool data_pool;
+static RingArena point_ring;
+static bool pools_ready;
+
+// Ground elements that continue one another are gathered into a run that
+// becomes one body with a single one-sided chain. Runs are cut at the end
+// of every structure, so everything generated can be driven on right
+// away, and the next run takes its first ghost vertex from the last one.
+#ifndef LANDSCAPE_RUN_POINTS
+#define LANDSCAPE_RUN_POINTS 256
+#endif
+// ends closer than this in meters are joined
+#define JOIN_DISTANCE 0.01f
+
+static b2Vec2 run_points[LANDSCAPE_RUN_POINTS];
+static int run_count;
+static int run_end_x;
+static bool run_joined; // starts where the last run ended
+// last two points of the last run
+static b2Vec2 tail_prev, tail_last;
+static bool tail_valid;
+
+// Generation is split in two: a producer places structures ahead into a
+// queue of elements, which is cheap, and the Box2D bodies are built from
+// the queue a few segments per tick, so a long structure doesn't cost one
+// frame. The producer touches nothing but its end of the queue,
+// g_world.last_x and last_y and its RNG, so it can run on another thread.
+#ifndef WORLDGEN_SEGMENT_BUDGET
+#define WORLDGEN_SEGMENT_BUDGET 48
+#endif
+// powers of two, the counters below wrap around
+#define GEN_QUEUE_ELEMENTS 128
+#define GEN_QUEUE_POINTS 4096
+// structures are placed this much driving time ahead of the view
+#define LOOKAHEAD_SECONDS 2
+
+typedef struct {
+	uint32_t first; // counter of its first point, the points are contiguous
+	int count;
+	int done; // points built, the last of them is shared with the rest
+	int end_x;
+	int place_x; // where its structure starts
+	int saved;   // segments decimation saved
+	bool structure_start;
+	TerrainKind terrain;
+} GenElement;
+
+// Single producer, single consumer: each side only advances its own
+// counters and publishes them with a release store.
+#ifdef WORLDGEN_THREAD
+#define LOAD_ACQUIRE(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#else
+#define LOAD_ACQUIRE(p) (*(p))
+#define STORE_RELEASE(p, v) (*(p) = (v))
+#endif
+
+static GenElement gen_queue[GEN_QUEUE_ELEMENTS];
+static b2Vec2 gen_points[GEN_QUEUE_POINTS];
+static uint32_t elements_in, elements_out;
+static uint32_t points_in, points_out;
+static int placed_x; // g_world.last_x once a structure is complete
+
+// producer side
+static int structure_x;
+static bool structure_started;
+static uint32_t rng_state = 1;
+static uint32_t runs; // since the seed was set, each run reseeds from both
+
+// consumer side
+static int built_x = INT_MIN; // terrain has bodies up to here
+// Only structures starting before the horizon are built. It never goes
+// back, so what is built and when doesn't depend on how far ahead the
+// producer happens to be.
+static int horizon = INT_MIN;
+static int saved_current, saved_last, saved_total;
+
+static int inline_target_x, inline_detail;
+
+static void inline_request(int target_x, int detail)
+{
+	inline_target_x = target_x;
+	inline_detail = detail;
+	while (worldgen_place_structure(target_x, detail)) {
+	}
+}
+
+static void inline_wait(void)
+{
+	inline_request(inline_target_x, inline_detail);
+}
+
+static void inline_stop(void)
+{
+}
+
+static const WorldgenProducer inline_producer = {inline_request, inline_wait, inline_stop};
+static const WorldgenProducer* producer = &inline_producer;
+
+static void init_pools(void)
+{
+	pool_init(&data_pool, data_storage, sizeof(data_storage[0]), WORLDGEN_MAX_BODIES + CAR_MAX_BODIES, "body data");
+	ring_init(&point_ring, point_storage, sizeof(point_storage), "terrain points");
+	pools_ready = true;
+}
 extern int zoom_out, view_field;
 
-b2BodyId worldgen_create_body(const b2BodyDef* def, BodyType type, float end_x)
+static BodyNode* landscape_at(int i)
 {
+	return &landscape[(landscape_head + i) % WORLDGEN_MAX_BODIES];
+}
+
+static b2BodyId create_body(const b2BodyDef* def, BodyType type)
+{
+	if (!pools_ready) init_pools();
+
+	BodyData* data = (BodyData*)pool_acquire(&data_pool);
+	if (!data) {
+		return b2_nullBodyId;
+	}
 	b2BodyId bodyId = b2CreateBody(g_world.worldId, def);
-	if (b2Body_IsValid(bodyId)) {
-		BodyData* data = (BodyData*)malloc(sizeof(BodyData));
-		if (data) {
-			data->type = type;
-			b2Body_SetUserData(bodyId, data);
-		}
+	if (!b2Body_IsValid(bodyId)) {
+		pool_release(&data_pool, data);
+		return b2_nullBodyId;
+	}
+	data->type = type;
+	b2Body_SetUserData(bodyId, data);
+	return bodyId;
+}
 
-		BodyNode* newNode = (BodyNode*)malloc(sizeof(BodyNode));
-		if (newNode) {
-			newNode->bodyId = bodyId;
-			newNode->type = type;
-			newNode->end_x = end_x;
-			newNode->next = g_world.body_list;
-			g_world.body_list = newNode;
-		}
+b2BodyId worldgen_create_body(const b2BodyDef* def, BodyType type)
+{
+	if (car_body_count == CAR_MAX_BODIES) {
+		printf("No room for car body\n");
+		return b2_nullBodyId;
+	}
+	b2BodyId bodyId = create_body(def, type);
+	if (B2_IS_NULL(bodyId)) {
+		return bodyId;
 	}
+	BodyNode* node = &car_bodies[car_body_count++];
+	memset(node, 0, sizeof(*node));
+	node->bodyId = bodyId;
+	node->type = type;
 	return bodyId;
 }
 
-void worldgen_clear_body_list(void)
+// Bounds are kept even when the ring is full and the node has no points,
+// they keep the landscape sorted.
+static void set_render_points(BodyNode* node, const b2Vec2* points, int count)
 {
-	BodyNode* current = g_world.body_list;
-	while (current != NULL) {
-		BodyNode* next = current->next;
-		if(b2Body_IsValid(current->bodyId)) {
-			void* userData = b2Body_GetUserData(current->bodyId);
-			if (userData) {
-				free(userData);
-			}
+	node->points = (vec2d*)ring_alloc(&point_ring, count * sizeof(vec2d));
+	node->point_count = node->points ? count : 0;
+	for (int i = 0; i < count; ++i) {
+		vec2d p = {floorf(points[i].x * WORLD_SCALE + 0.5f), floorf(points[i].y * WORLD_SCALE + 0.5f)};
+		if (node->points) {
+			node->points[i] = p;
 		}
-		free(current);
-		current = next;
+		if (i == 0) {
+			node->min_x = node->max_x = p.x;
+			node->min_y = node->max_y = p.y;
+		}
+		if (p.x < node->min_x) node->min_x = p.x;
+		if (p.x > node->max_x) node->max_x = p.x;
+		if (p.y < node->min_y) node->min_y = p.y;
+		if (p.y > node->max_y) node->max_y = p.y;
 	}
-	g_world.body_list = NULL;
 }
 
-void world_create_two_sided_landscape(const b2Vec2* points, int count, int end_x)
+// Pieces of one structure can start left of the one before, those few
+// are moved up.
+static void insert_landscape(const BodyNode* node)
 {
-	if (count < 2) return;
+	int pos = landscape_count++;
+	while (pos > 0 && landscape_at(pos - 1)->min_x > node->min_x) {
+		*landscape_at(pos) = *landscape_at(pos - 1);
+		pos--;
+	}
+	*landscape_at(pos) = *node;
+	if (landscape_count > landscape_high_water) landscape_high_water = landscape_count;
+
+	int reach = pos > 0 ? landscape_at(pos - 1)->reach_x : node->max_x;
+	for (int i = pos; i < landscape_count; i++) {
+		BodyNode* n = landscape_at(i);
+		if (n->max_x > reach) reach = n->max_x;
+		n->reach_x = reach;
+	}
+}
+
+static void free_body_node(BodyNode* node)
+{
+	if (b2Body_IsValid(node->bodyId)) {
+		pool_release(&data_pool, b2Body_GetUserData(node->bodyId));
+	}
+	ring_release(&point_ring, node->points);
+}
+
+int worldgen_landscape_count(void)
+{
+	return landscape_count;
+}
+
+const BodyNode* worldgen_landscape(int i)
+{
+	return landscape_at(i);
+}
+
+void worldgen_landscape_range(int min_x, int max_x, int* first, int* end)
+{
+	// reach_x never decreases, min_x is sorted
+	int lo = 0, hi = landscape_count;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (landscape_at(mid)->reach_x < min_x) lo = mid + 1;
+		else hi = mid;
+	}
+	*first = lo;
+	hi = landscape_count;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (landscape_at(mid)->min_x <= max_x) lo = mid + 1;
+		else hi = mid;
+	}
+	*end = lo;
+}
+
+int worldgen_car_body_count(void)
+{
+	return car_body_count;
+}
+
+const BodyNode* worldgen_car_body(int i)
+{
+	return &car_bodies[i];
+}
+
+// the generator state a run starts from, nearby seeds and runs give
+// unrelated sequences
+static uint32_t run_seed(uint32_t seed, uint32_t run)
+{
+	uint32_t x = seed + run * 0x9e3779b9u;
+	x ^= x >> 16;
+	x *= 0x85ebca6bu;
+	x ^= x >> 13;
+	x *= 0xc2b2ae35u;
+	x ^= x >> 16;
+	// xorshift never leaves zero
+	return x ? x : 1;
+}
+
+// Drops the records only, the Box2D bodies go with their world.
+void worldgen_clear_body_list(void)
+{
+	if (!pools_ready) init_pools();
+	producer->stop();
+	// A stopped producer may have placed any number of structures past
+	// what was built. Reseeding makes the next run independent of that.
+	rng_state = run_seed(g_world.seed, runs++);
+	terrain_kind = TERRAIN_GROUND;
+	landscape_head = 0;
+	landscape_count = 0;
+	car_body_count = 0;
+	run_count = 0;
+	tail_valid = false;
+	elements_in = elements_out = 0;
+	points_in = points_out = 0;
+	placed_x = INT_MIN;
+	built_x = INT_MIN;
+	horizon = INT_MIN;
+	pool_reset(&data_pool);
+	ring_reset(&point_ring);
+}
+
+void worldgen_set_producer(const WorldgenProducer* fn)
+{
+	producer->stop();
+	producer = fn ? fn : &inline_producer;
+}
+
+void worldgen_seed(uint32_t seed)
+{
+	producer->stop();
+	g_world.seed = seed;
+	runs = 0;
+	rng_state = run_seed(seed, runs);
+}
+
+// xorshift32, the generator's own so its sequence only depends on the
+// seed, whichever thread places the structures
+static int gen_rand(void)
+{
+	uint32_t x = rng_state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	rng_state = x;
+	return (int)(x >> 1);
+}
+
+void worldgen_print_pool_usage(void)
+{
+	printf("Bodies: landscape %d/%d (max %d), car %d, data %d/%d (max %d), points %d/%d bytes (max %d)\n",
+		landscape_count, WORLDGEN_MAX_BODIES, landscape_high_water, car_body_count,
+		data_pool.used, data_pool.capacity, data_pool.high_water,
+		point_ring.used, point_ring.size, point_ring.high_water);
+	printf("Generation: %d elements queued, %d/%d points, built %d ahead of the car\n",
+		(int)(LOAD_ACQUIRE(&elements_in) - elements_out), (int)(points_in - points_out), GEN_QUEUE_POINTS,
+		built_x - (int)(g_car.position.x * WORLD_SCALE));
+	printf("Decimation: %d segments saved in the last structure, %d in all\n", saved_last, saved_total);
+}
+
+void world_set_terrain_kind(TerrainKind kind)
+{
+	terrain_kind = kind;
+}
+
+static bool points_join(b2Vec2 a, b2Vec2 b)
+{
+	return fabsf(a.x - b.x) < JOIN_DISTANCE && fabsf(a.y - b.y) < JOIN_DISTANCE;
+}
+
+// ghost for a free end: the last segment carried on straight
+static b2Vec2 extend(b2Vec2 from, b2Vec2 to)
+{
+	return (b2Vec2){2 * to.x - from.x, 2 * to.y - from.y};
+}
+
+// Free standing pieces and floating terrain can be hit from below, so
+// they get a reversed chain as well.
+static void create_landscape_body(const b2Vec2* points, int count, int end_x, TerrainKind terrain, const b2Vec2* ghost_prev)
+{
+	if (landscape_count == WORLDGEN_MAX_BODIES) return;
 
 	b2BodyDef groundBodyDef = b2DefaultBodyDef();
-	b2BodyId groundBodyId = worldgen_create_body(&groundBodyDef, BODY_TYPE_LANDSCAPE, end_x/(float)WORLD_SCALE);
+	b2BodyId groundBodyId = create_body(&groundBodyDef, BODY_TYPE_LANDSCAPE);
+	if (B2_IS_NULL(groundBodyId)) return;
+	BodyNode node = {0};
+	node.bodyId = groundBodyId;
+	node.type = BODY_TYPE_LANDSCAPE;
+	node.terrain = terrain;
+	set_render_points(&node, points, count);
+	node.end_x = (end_x > node.max_x ? end_x : node.max_x) / (float)WORLD_SCALE;
+	insert_landscape(&node);
 
-	b2ChainDef topChainDef = b2DefaultChainDef();
-	b2Vec2 points_with_dummy_ghosts[count + 2];
-	points_with_dummy_ghosts[0] = points[0]; // ghost point
+	b2Vec2 chain_points[count + 2];
+	chain_points[0] = ghost_prev ? *ghost_prev : extend(points[1], points[0]);
 	for (int i = 0; i < count; ++i) {
-		points_with_dummy_ghosts[1 + i] = points[i];
+		chain_points[1 + i] = points[i];
 	}
-	points_with_dummy_ghosts[count + 1] = points[count - 1]; // ghost point
-	topChainDef.points = points_with_dummy_ghosts;
-	topChainDef.count = count + 2;
-	b2CreateChain(groundBodyId, &topChainDef);
+	chain_points[count + 1] = extend(points[count - 2], points[count - 1]);
 
-	b2Vec2 bottom_points_with_dummy_ghosts[count + 2];
-	bottom_points_with_dummy_ghosts[0] = points[count - 1]; // ghost point
-	for (int i = 0; i < count; ++i) {
-		bottom_points_with_dummy_ghosts[1 + i] = points[count - 1 - i];
+	b2ChainDef chainDef = b2DefaultChainDef();
+	chainDef.points = chain_points;
+	chainDef.count = count + 2;
+	b2CreateChain(groundBodyId, &chainDef);
+
+	if (terrain == TERRAIN_GROUND && ghost_prev) {
+		return;
+	}
+	for (int i = 0, j = count + 1; i < j; i++, j--) {
+		b2Vec2 temp = chain_points[i];
+		chain_points[i] = chain_points[j];
+		chain_points[j] = temp;
 	}
-	bottom_points_with_dummy_ghosts[count + 1] = points[0]; // ghost point
+	b2CreateChain(groundBodyId, &chainDef);
+}
+
+static void flush_run(void)
+{
+	if (run_count >= 2) {
+		create_landscape_body(run_points, run_count, run_end_x, TERRAIN_GROUND, run_joined ? &tail_prev : NULL);
+		tail_prev = run_points[run_count - 2];
+		tail_last = run_points[run_count - 1];
+		tail_valid = true;
+	}
+	run_count = 0;
+}
+
+static void start_run(b2Vec2 p)
+{
+	run_joined = tail_valid && points_join(tail_last, p);
+	run_points[0] = p;
+	run_count = 1;
+	run_end_x = INT_MIN;
+}
+
+static void add_floating(const b2Vec2* points, int count, int end_x, TerrainKind terrain)
+{
+	b2Vec2 unique[count];
+	int n = 0;
+	for (int i = 0; i < count; i++) {
+		if (n == 0 || !points_join(unique[n - 1], points[i])) {
+			unique[n++] = points[i];
+		}
+	}
+	if (n >= 2) {
+		create_landscape_body(unique, n, end_x, terrain, NULL);
+	}
+}
 
-	b2ChainDef bottomChainDef = b2DefaultChainDef();
-	bottomChainDef.points = bottom_points_with_dummy_ghosts;
-	bottomChainDef.count = count + 2;
-	b2CreateChain(groundBodyId, &bottomChainDef);
+static void add_ground(const b2Vec2* points, int count, int end_x)
+{
+	if (run_count == 0 || !points_join(run_points[run_count - 1], points[0])) {
+		flush_run();
+		start_run(points[0]);
+	}
+	for (int i = 1; i < count; i++) {
+		if (points_join(run_points[run_count - 1], points[i])) continue;
+		if (run_count == LANDSCAPE_RUN_POINTS) {
+			b2Vec2 last = run_points[run_count - 1];
+			flush_run();
+			start_run(last);
+		}
+		run_points[run_count++] = points[i];
+	}
+	if (end_x > run_end_x) run_end_x = end_x;
+}
+
+void world_add_landscape(const b2Vec2* points, int count, int end_x)
+{
+	if (count < 2) return;
+
+	// the end of the ring is skipped when the points don't fit there
+	uint32_t first = points_in;
+	uint32_t offset = first % GEN_QUEUE_POINTS;
+	if (offset + count > GEN_QUEUE_POINTS) first += GEN_QUEUE_POINTS - offset;
+	if (elements_in - LOAD_ACQUIRE(&elements_out) == GEN_QUEUE_ELEMENTS ||
+	    first + count - LOAD_ACQUIRE(&points_out) > GEN_QUEUE_POINTS) {
+		printf("Generation queue full\n");
+		return;
+	}
+	b2Vec2* copy = &gen_points[first % GEN_QUEUE_POINTS];
+	for (int i = 0; i < count; i++) {
+		copy[i] = points[i];
+	}
+
+	GenElement* e = &gen_queue[elements_in % GEN_QUEUE_ELEMENTS];
+	e->first = first;
+	e->count = count;
+	e->done = 0;
+	e->end_x = end_x;
+	e->place_x = structure_x;
+	e->saved = element_take_saved_segments();
+	e->structure_start = structure_started;
+	e->terrain = terrain_kind;
+	structure_started = false;
+	points_in = first + count;
+	STORE_RELEASE(&elements_in, elements_in + 1);
+}
+
+// Builds up to `budget` segments of the element and returns how many it
+// built. Floating pieces are taken whole, cut up they would get free ends.
+static int build_element(GenElement* e, int budget)
+{
+	const b2Vec2* points = &gen_points[e->first % GEN_QUEUE_POINTS];
+	int first = e->done;
+	int last = e->count - 1;
+	if (e->terrain == TERRAIN_GROUND) {
+		if (last > first + budget) last = first + budget;
+		add_ground(points + first, last - first + 1, e->end_x);
+	} else {
+		add_floating(points, e->count, e->end_x, e->terrain);
+	}
+	for (int i = first; i <= last; i++) {
+		int x = points[i].x * WORLD_SCALE;
+		if (x > built_x) built_x = x;
+	}
+	e->done = last;
+	return last - first;
+}
+
+// The next element of a structure starting before the horizon, once the
+// producer has it. NULL when everything up to the horizon was taken.
+static GenElement* next_element(void)
+{
+	for (;;) {
+		if (LOAD_ACQUIRE(&elements_in) != elements_out) {
+			GenElement* e = &gen_queue[elements_out % GEN_QUEUE_ELEMENTS];
+			return e->place_x < horizon ? e : NULL;
+		}
+		if (LOAD_ACQUIRE(&placed_x) >= horizon) {
+			// a structure's elements are all in before placed_x moves
+			if (LOAD_ACQUIRE(&elements_in) == elements_out) return NULL;
+			continue;
+		}
+		producer->wait();
+	}
+}
+
+static void pop_element(const GenElement* e)
+{
+	if (e->structure_start) {
+		saved_last = saved_current;
+		saved_current = 0;
+	}
+	saved_current += e->saved;
+	saved_total += e->saved;
+	STORE_RELEASE(&points_out, e->first + e->count);
+	STORE_RELEASE(&elements_out, elements_out + 1);
+}
+
+// Takes elements off the queue until the budget is spent, and past it
+// while the terrain doesn't reach `min_x` yet.
+static void build_landscape(int budget, int min_x)
+{
+	while (WORLDGEN_MAX_BODIES - landscape_count >= 2) {
+		if (budget <= 0 && built_x >= min_x) break;
+		GenElement* e = next_element();
+		if (!e) break;
+		// a floating piece that doesn't fit waits for a full budget
+		if (e->terrain != TERRAIN_GROUND && e->count - 1 > budget &&
+		    budget < WORLDGEN_SEGMENT_BUDGET && built_x >= min_x) {
+			break;
+		}
+		budget -= build_element(e, budget > 0 ? budget : WORLDGEN_SEGMENT_BUDGET);
+		if (e->done == e->count - 1) {
+			pop_element(e);
+		}
+	}
+	// what was built can be driven on, the next tick's run picks up the
+	// ghost vertex from here
+	flush_run();
 }
 
 void world_generate_initial_landscape(void)
@@ -95,81 +583,105 @@ void world_generate_initial_landscape(void)
 		{start_platform_end_x / WORLD_SCALE, g_world.last_y / WORLD_SCALE},
 	};
 
-	world_create_two_sided_landscape(points, 3, start_platform_end_x);
+	structure_x = border_start_x;
+	structure_started = true;
+	world_add_landscape(points, 3, start_platform_end_x);
 	g_world.last_x = start_platform_end_x;
+	STORE_RELEASE(&placed_x, g_world.last_x);
+
+	horizon = start_platform_end_x;
+	build_landscape(0, start_platform_end_x);
 }
 
 void world_generate_next_structure(void)
 {
 	EndPoint ep = {g_world.last_x, g_world.last_y};
-	int id;
+	int id, len;
+
+	structure_x = g_world.last_x;
+	structure_started = true;
 
 	do {
-		id = rand() % 10;
+		id = gen_rand() % 10;
 	} while (id == prev_structure_id);
 
 	if (g_world.last_y < -1000 || 1000 < g_world.last_y) {
-		ep = place_floor_struct(g_world.last_x, g_world.last_y, 1000 + rand() % 4 * 100, (rand() % 7 - 3) * 100);
+		// one draw per statement, the order of arguments is unspecified
+		len = 1000 + gen_rand() % 4 * 100;
+		ep = place_floor_struct(g_world.last_x, g_world.last_y, len, (gen_rand() % 7 - 3) * 100);
 	} else {
 		switch (id)
 		{
 		case STRUCTURE_ID_ARC1:
-			int halfPeriods = 4 + rand() % 8;
+			int halfPeriods = 4 + gen_rand() % 8;
 			int l = halfPeriods * 180;
 			int amp = 15;
 			ep = place_sin_struct(g_world.last_x, g_world.last_y, l, halfPeriods, 0, amp);
 			break;
 		case STRUCTURE_ID_SIN:
-			ep = place_arc1_struct(g_world.last_x, g_world.last_y, 200 + abs(rand()) % 400);
+			ep = place_arc1_struct(g_world.last_x, g_world.last_y, 200 + gen_rand() % 400);
 			break;
 		case STRUCTURE_ID_FLOOR_STAT:
-			ep = place_horizontal_floor_struct(g_world.last_x, g_world.last_y, 400 + rand() % 10 * 100);
+			ep = place_horizontal_floor_struct(g_world.last_x, g_world.last_y, 400 + gen_rand() % 10 * 100);
 			break;
 		case STRUCTURE_ID_ARC2:
-			ep = place_arc2_struct(g_world.last_x, g_world.last_y, 500 + rand() % 500, 20);
+			ep = place_arc2_struct(g_world.last_x, g_world.last_y, 500 + gen_rand() % 500, 20);
 			break;
 		case STRUCTURE_ID_ABYSS:
-			ep = place_abyss_struct(g_world.last_x, g_world.last_y, rand() % 6 * 1000);
+			ep = place_abyss_struct(g_world.last_x, g_world.last_y, gen_rand() % 6 * 1000);
 			break;
 		case STRUCTURE_ID_SLANTED_DOTTED_LINE:
-			int n = rand() % 6 + 5;
+			int n = gen_rand() % 6 + 5;
 			ep = place_slanted_dotted_line_struct(g_world.last_x, g_world.last_y, n);
 			break;
 		default:
-			ep = place_floor_struct(g_world.last_x, g_world.last_y, 400 + rand() % 10 * 100, (rand() % 7 - 3) * 100);
+			len = 400 + gen_rand() % 10 * 100;
+			ep = place_floor_struct(g_world.last_x, g_world.last_y, len, (gen_rand() % 7 - 3) * 100);
 			break;
 		}
 	}
 
 	g_world.last_x = ep.x;
 	g_world.last_y = ep.y;
+	STORE_RELEASE(&placed_x, g_world.last_x);
+}
+
+bool worldgen_place_structure(int target_x, int detail)
+{
+	if (g_world.last_x >= target_x) return false;
+	// room for the largest structure, so none is ever cut short
+	if (elements_in - LOAD_ACQUIRE(&elements_out) > GEN_QUEUE_ELEMENTS - STRUCTURE_MAX_ELEMENTS ||
+	    points_in - LOAD_ACQUIRE(&points_out) > GEN_QUEUE_POINTS / 2) {
+		return false;
+	}
+	element_set_detail(detail);
+	world_generate_next_structure();
+	return true;
 }
 
 static void remove_old_structures(void)
 {
-	BodyNode** current_ptr = &g_world.body_list;
-
-	while (*current_ptr) {
-		BodyNode* entry = *current_ptr;
-		if (entry->type == BODY_TYPE_LANDSCAPE && entry->end_x < g_car.position.x - view_field * 2) {
-			void* userData = b2Body_GetUserData(entry->bodyId);
-			if (userData) {
-				free(userData);
-			}
-			b2DestroyBody(entry->bodyId);
-			*current_ptr = entry->next;
-			free(entry);
-		} else {
-			current_ptr = &entry->next;
-		}
+	while (landscape_count > 0 && landscape[landscape_head].end_x < g_car.position.x - view_field * 2 / WORLD_SCALE) {
+		BodyNode* entry = &landscape[landscape_head];
+		free_body_node(entry);
+		b2DestroyBody(entry->bodyId);
+		landscape_head = (landscape_head + 1) % WORLDGEN_MAX_BODIES;
+		landscape_count--;
 	}
 }
 
 void world_generator_tick(void)
 {
-	if (g_car.position.x + view_field*2 / WORLD_SCALE > g_world.last_x / WORLD_SCALE) {
-		world_generate_next_structure();
-	}
+	int car_x = g_car.position.x * WORLD_SCALE;
+	float speed = b2Body_GetLinearVelocity(g_car.chassis).x;
+	int ahead = view_field * 2;
+	if (speed > 0) ahead += (int)(speed * WORLD_SCALE) * LOOKAHEAD_SECONDS;
+
+	if (car_x + ahead > horizon) horizon = car_x + ahead;
+	producer->request(horizon, g_quality->detail);
+
+	// the view always reaches built terrain, however little is left
+	build_landscape(WORLDGEN_SEGMENT_BUDGET, car_x + view_field * 2);
 
 	remove_old_structures();
 }
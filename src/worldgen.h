@@ -4,10 +4,46 @@
 #include "box2d/types.h"
 #include "game_types.h"
 
-b2BodyId worldgen_create_body(const b2BodyDef* def, BodyType type, float end_x);
+// for the car, landscape is created through the functions below
+b2BodyId worldgen_create_body(const b2BodyDef* def, BodyType type);
 void worldgen_clear_body_list(void);
+int worldgen_car_body_count(void);
+const BodyNode* worldgen_car_body(int i);
+
+// Landscape oldest first, which is also left to right by min_x.
+int worldgen_landscape_count(void);
+const BodyNode* worldgen_landscape(int i);
+// Indices [*first, *end) of the landscape that can overlap min_x..max_x
+// (emini units) horizontally.
+void worldgen_landscape_range(int min_x, int max_x, int* first, int* end);
+void worldgen_print_pool_usage(void);
+
+// terrain created from now on, TERRAIN_GROUND unless set otherwise
+void world_set_terrain_kind(TerrainKind kind);
+// Queues a terrain element, world_generator_tick builds it later. Ground
+// continuing the previous element shares its body, anything else starts a
+// new one.
+void world_add_landscape(const b2Vec2* points, int count, int end_x);
+// Structures are placed by a producer that touches nothing but the
+// generation queue, g_world.last_x and last_y and the generator's RNG, so
+// a platform can run it on a thread. By default it runs inline.
+typedef struct {
+	// place structures until g_world.last_x reaches target_x
+	void (*request)(int target_x, int detail);
+	// block until the producer placed another structure or ran out of work
+	void (*wait)(void);
+	// block until the producer is idle, it stays so until the next request
+	void (*stop)(void);
+} WorldgenProducer;
+
+void worldgen_set_producer(const WorldgenProducer* producer); // NULL for inline
+// Producer side: places the next structure if g_world.last_x is short of
+// target_x and the queue has room for it. Returns whether it did.
+bool worldgen_place_structure(int target_x, int detail);
+// Each run, from one worldgen_clear_body_list() to the next, follows from
+// the seed and the number of runs before it.
+void worldgen_seed(uint32_t seed);
 
-void world_create_two_sided_landscape(const b2Vec2* points, int count, int end_x);
 void world_generate_initial_landscape(void);
 void world_generate_next_structure(void);
 void world_generator_tick(void);
@@ -0,0 +1,900 @@
+#include "graphics.h"
+#include "fixmath.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const uint8_t font_data[] = {
+#include "font8x16.h"
+};
+
+// Span kernel: everything that fills runs of pixels ends up here.
+// Aligned pixel groups are written as whole words (two RGB565 pixels on
+// 32-bit targets, four on 64-bit hosts), the unaligned head and the tail
+// pixel by pixel.
+#if UINTPTR_MAX > 0xffffffffu
+typedef uint64_t __attribute__((may_alias)) span_word_t;
+#else
+typedef uint32_t __attribute__((may_alias)) span_word_t;
+#endif
+
+#define SPAN_WORD_PIXELS ((int)(sizeof(span_word_t) / sizeof(uint16_t)))
+
+static void fill_span(uint16_t* dst, int n, uint16_t color)
+{
+	while (n > 0 && ((uintptr_t)dst & (sizeof(span_word_t) - 1))) {
+		*dst++ = color;
+		n--;
+	}
+
+	span_word_t word = color * (span_word_t)0x0001000100010001ull;
+	span_word_t* p = (span_word_t*)dst;
+	int words = n / SPAN_WORD_PIXELS;
+	for (; words >= 4; words -= 4, p += 4) {
+		p[0] = word;
+		p[1] = word;
+		p[2] = word;
+		p[3] = word;
+	}
+	while (words-- > 0) {
+		*p++ = word;
+	}
+
+	dst = (uint16_t*)p;
+	for (n %= SPAN_WORD_PIXELS; n > 0; n--) {
+		*dst++ = color;
+	}
+}
+
+// Pixels are addressed by offset into whichever buffer the context draws
+// to. Indexed targets take a byte per pixel and memset is their kernel.
+static void fill_pixels(GraphicsContext* ctx, int offset, int n, uint16_t color)
+{
+	if (ctx->indexbuf) {
+		memset(ctx->indexbuf + offset, (uint8_t)color, n);
+	} else {
+		fill_span(ctx->framebuf + offset, n, color);
+	}
+}
+
+static inline void put_pixel(GraphicsContext* ctx, int offset, uint16_t color)
+{
+	if (ctx->indexbuf) {
+		ctx->indexbuf[offset] = (uint8_t)color;
+	} else {
+		ctx->framebuf[offset] = color;
+	}
+}
+
+// Clips a horizontal span once and hands it to the kernel.
+static void fill_hspan(GraphicsContext* ctx, int x0, int x1, int y, uint16_t color)
+{
+	if (y < 0 || y >= ctx->height) return;
+	if (x0 < 0) x0 = 0;
+	if (x1 >= ctx->width) x1 = ctx->width - 1;
+	if (x0 > x1) return;
+	fill_pixels(ctx, y * ctx->width + x0, x1 - x0 + 1, color);
+}
+
+static int floor_div(int64_t a, int b, int* rem)
+{
+	int64_t q = a / b;
+	int64_t r = a % b;
+	if (r < 0) {
+		q--;
+		r += b;
+	}
+	*rem = (int)r;
+	return (int)q;
+}
+
+static int64_t ceil_div64(int64_t a, int64_t b)
+{
+	int64_t q = a / b;
+	if (a % b > 0) q++;
+	return q;
+}
+
+static int round_div(int64_t a, int64_t b)
+{
+	int rem;
+	return floor_div(a + b / 2, b, &rem);
+}
+
+static int rect_area(int x0, int y0, int x1, int y1)
+{
+	return (x1 - x0) * (y1 - y0);
+}
+
+// Adds a rect to the list, merging it into the rect it grows least
+// when it overlaps one or when the list is full.
+static void damage_add(DamageList* list, int x0, int y0, int x1, int y1)
+{
+	int best = -1;
+	int best_extra = 0;
+
+	for (int i = 0; i < list->count; i++) {
+		GfxRect* r = &list->rects[i];
+		int ux0 = r->x0 < x0 ? r->x0 : x0;
+		int uy0 = r->y0 < y0 ? r->y0 : y0;
+		int ux1 = r->x1 > x1 ? r->x1 : x1;
+		int uy1 = r->y1 > y1 ? r->y1 : y1;
+		int extra = rect_area(ux0, uy0, ux1, uy1) - rect_area(r->x0, r->y0, r->x1, r->y1) - rect_area(x0, y0, x1, y1);
+		if (best < 0 || extra < best_extra) {
+			best = i;
+			best_extra = extra;
+		}
+	}
+
+	if (best < 0 || (best_extra > 0 && list->count < DAMAGE_MAX_RECTS)) {
+		list->rects[list->count++] = (GfxRect){x0, y0, x1, y1};
+		return;
+	}
+
+	GfxRect* r = &list->rects[best];
+	if (x0 < r->x0) r->x0 = x0;
+	if (y0 < r->y0) r->y0 = y0;
+	if (x1 > r->x1) r->x1 = x1;
+	if (y1 > r->y1) r->y1 = y1;
+}
+
+// Records that [x0, x1) x [y0, y1) was drawn this frame.
+static void mark_damage(GraphicsContext* ctx, int x0, int y0, int x1, int y1)
+{
+	if (!ctx->track_damage) return;
+	if (x0 < 0) x0 = 0;
+	if (y0 < 0) y0 = 0;
+	if (x1 > ctx->width) x1 = ctx->width;
+	if (y1 > ctx->height) y1 = ctx->height;
+	if (x0 >= x1 || y0 >= y1) return;
+	damage_add(&ctx->damage, x0, y0, x1, y1);
+}
+
+static void plot(GraphicsContext* ctx, int x, int y, uint16_t color)
+{
+	if (x >= 0 && x < ctx->width && y >= 0 && y < ctx->height) {
+		put_pixel(ctx, y * ctx->width + x, color);
+	}
+}
+
+void clear(GraphicsContext* ctx)
+{
+	fill(ctx, 0);
+}
+
+void fill(GraphicsContext* ctx, uint16_t color)
+{
+	mark_damage(ctx, 0, 0, ctx->width, ctx->height);
+	fill_pixels(ctx, 0, ctx->width * ctx->height, color);
+}
+
+// Starts a frame: without damage tracking the whole context is cleared,
+// with it only what the previous frame drew.
+void begin_frame(GraphicsContext* ctx)
+{
+	if (!ctx->track_damage) {
+		clear(ctx);
+		return;
+	}
+
+	for (int i = 0; i < ctx->damage.count; i++) {
+		GfxRect* r = &ctx->damage.rects[i];
+		int row = r->y0 * ctx->width + r->x0;
+		for (int y = r->y0; y < r->y1; y++, row += ctx->width) {
+			fill_pixels(ctx, row, r->x1 - r->x0, 0);
+		}
+	}
+	ctx->prev_damage = ctx->damage;
+	ctx->damage.count = 0;
+	ctx->unchanged = false;
+}
+
+// Ends a frame without drawing: the buffer keeps the last frame, and
+// nothing has to be refreshed.
+void keep_frame(GraphicsContext* ctx)
+{
+	ctx->unchanged = true;
+}
+
+// Marks the whole context as drawn, so the next frame clears and
+// refreshes all of it. Needed whenever the buffer content is unknown.
+void damage_reset(GraphicsContext* ctx)
+{
+	ctx->damage.rects[0] = (GfxRect){0, 0, ctx->width, ctx->height};
+	ctx->damage.count = 1;
+	ctx->prev_damage.count = 0;
+}
+
+// Regions that differ from the previously shown frame: whatever the
+// last frame drew (now cleared) plus whatever this frame drew.
+void add_damage(GraphicsContext* ctx, GfxRect rect)
+{
+	mark_damage(ctx, rect.x0, rect.y0, rect.x1, rect.y1);
+}
+
+int get_refresh_rects(const GraphicsContext* ctx, GfxRect* out, int max_count)
+{
+	if (ctx->unchanged) {
+		return 0;
+	}
+	if (!ctx->track_damage) {
+		if (max_count < 1) return 0;
+		out[0] = (GfxRect){0, 0, ctx->width, ctx->height};
+		return 1;
+	}
+
+	DamageList list = ctx->prev_damage;
+	for (int i = 0; i < ctx->damage.count; i++) {
+		const GfxRect* r = &ctx->damage.rects[i];
+		damage_add(&list, r->x0, r->y0, r->x1, r->y1);
+	}
+
+	int count = list.count < max_count ? list.count : max_count;
+	for (int i = 0; i < count; i++) {
+		out[i] = list.rects[i];
+	}
+	return count;
+}
+
+int refresh_display(GraphicsContext* back, const GraphicsContext* front, RefreshFn push)
+{
+	GfxRect rects[2 * DAMAGE_MAX_RECTS];
+	int count = get_refresh_rects(back, rects, DAMAGE_MAX_RECTS);
+	if (count > 0 && back != front && back->track_damage) {
+		// each buffer holds nothing but its own frame, so the two differ
+		// only where either of them drew
+		count = back->damage.count;
+		memcpy(rects, back->damage.rects, count * sizeof(GfxRect));
+		memcpy(rects + count, front->damage.rects, front->damage.count * sizeof(GfxRect));
+		count += front->damage.count;
+	}
+	if (count == 0) {
+		return 0;
+	}
+
+	int y0 = rects[0].y0, y1 = rects[0].y1;
+	for (int i = 1; i < count; i++) {
+		if (rects[i].y0 < y0) y0 = rects[i].y0;
+		if (rects[i].y1 > y1) y1 = rects[i].y1;
+	}
+	push(back, y0, y1);
+	return y1 - y0;
+}
+
+static void expand_span(const uint8_t* src, uint16_t* dst, int n, const uint16_t* lut)
+{
+	for (; n >= 4; n -= 4, src += 4, dst += 4) {
+		dst[0] = lut[src[0]];
+		dst[1] = lut[src[1]];
+		dst[2] = lut[src[2]];
+		dst[3] = lut[src[3]];
+	}
+	while (n-- > 0) {
+		*dst++ = lut[*src++];
+	}
+}
+
+// Indexed targets: converts what changed since the last expansion, the
+// same regions get_refresh_rects() reports, to RGB565 in framebuf.
+void expand_frame(GraphicsContext* ctx)
+{
+	if (!ctx->indexbuf || !ctx->framebuf) return;
+
+	GfxRect rects[DAMAGE_MAX_RECTS];
+	int count = get_refresh_rects(ctx, rects, DAMAGE_MAX_RECTS);
+	for (int i = 0; i < count; i++) {
+		const GfxRect* r = &rects[i];
+		int row = r->y0 * ctx->width + r->x0;
+		for (int y = r->y0; y < r->y1; y++, row += ctx->width) {
+			expand_span(ctx->indexbuf + row, ctx->framebuf + row, r->x1 - r->x0, ctx->palette->colors);
+		}
+	}
+}
+
+void draw_pixel(GraphicsContext* ctx, int x, int y, uint16_t color) {
+	mark_damage(ctx, x, y, x + 1, y + 1);
+	plot(ctx, x, y, color);
+}
+
+// One pixel wide line. It walks the major axis; the minor coordinate at
+// step i is round(i * minor / major), known in closed form. So the step
+// range can be clipped against the context before drawing (Liang-Barsky
+// style, on integers), and a clipped line keeps the pixels of the
+// unclipped one.
+static void draw_thin_line(GraphicsContext* ctx, int x0, int y0, int x1, int y1, uint16_t color)
+{
+	int adx = abs(x1 - x0);
+	int ady = abs(y1 - y0);
+	int sx = x0 < x1 ? 1 : -1;
+	int sy = y0 < y1 ? 1 : -1;
+
+	int major, minor, maj0, min0, maj_dir, min_dir, maj_limit, min_limit, maj_stride, min_stride;
+	if (adx >= ady) {
+		major = adx; minor = ady;
+		maj0 = x0; min0 = y0;
+		maj_dir = sx; min_dir = sy;
+		maj_limit = ctx->width; min_limit = ctx->height;
+		maj_stride = sx; min_stride = sy * ctx->width;
+	} else {
+		major = ady; minor = adx;
+		maj0 = y0; min0 = x0;
+		maj_dir = sy; min_dir = sx;
+		maj_limit = ctx->height; min_limit = ctx->width;
+		maj_stride = sy * ctx->width; min_stride = sx;
+	}
+
+	if (major == 0) {
+		plot(ctx, x0, y0, color);
+		return;
+	}
+
+	// steps that keep the major coordinate inside
+	int64_t lo = 0, hi = major;
+	int64_t maj_lo = maj_dir > 0 ? -(int64_t)maj0 : (int64_t)maj0 - (maj_limit - 1);
+	int64_t maj_hi = maj_dir > 0 ? (int64_t)maj_limit - 1 - maj0 : (int64_t)maj0;
+	if (maj_lo > lo) lo = maj_lo;
+	if (maj_hi < hi) hi = maj_hi;
+
+	// minor offset f(i) = floor((2*i*minor + major) / (2*major)) must stay in [a, b]
+	int64_t a = min_dir > 0 ? -(int64_t)min0 : (int64_t)min0 - (min_limit - 1);
+	int64_t b = min_dir > 0 ? (int64_t)min_limit - 1 - min0 : (int64_t)min0;
+	if (minor == 0) {
+		if (a > 0 || b < 0) return;
+	} else {
+		int64_t min_lo = ceil_div64((2 * a - 1) * major, 2 * (int64_t)minor);
+		int64_t min_hi = ceil_div64((2 * b + 1) * major, 2 * (int64_t)minor) - 1;
+		if (min_lo > lo) lo = min_lo;
+		if (min_hi < hi) hi = min_hi;
+	}
+	if (lo > hi) return;
+
+	int64_t e = 2 * lo * minor + major;
+	int f = (int)(e / (2 * major));
+	int rem = (int)(e % (2 * major));
+	int x = x0 + (adx >= ady ? sx * (int)lo : sx * f);
+	int y = y0 + (adx >= ady ? sy * f : sy * (int)lo);
+
+#define WALK_LINE(p) \
+	for (int64_t i = lo; i <= hi; i++) { \
+		*p = color; \
+		p += maj_stride; \
+		rem += 2 * minor; \
+		if (rem >= 2 * major) { \
+			rem -= 2 * major; \
+			p += min_stride; \
+		} \
+	}
+
+	if (ctx->indexbuf) {
+		uint8_t* p = ctx->indexbuf + y * ctx->width + x;
+		WALK_LINE(p);
+	} else {
+		uint16_t* p = ctx->framebuf + y * ctx->width + x;
+		WALK_LINE(p);
+	}
+#undef WALK_LINE
+}
+
+// Thick line: a span-filled quad around the segment plus the caps. The
+// polygon filler clips the quad against the context, so only visible
+// rows are walked.
+static void draw_thick_line(GraphicsContext* ctx, int x0, int y0, int x1, int y1, int width, int cap, uint16_t color)
+{
+	int r = width / 2;
+	int64_t dx = x1 - x0;
+	int64_t dy = y1 - y0;
+	uint32_t len = isqrt64(dx * dx + dy * dy);
+
+	if (len == 0) {
+		if (cap == LINE_CAP_ROUND) {
+			draw_solid_circle(ctx, x0, y0, r, color);
+		} else if (cap == LINE_CAP_SQUARE) {
+			fill_rect(ctx, x0 - r, y0 - r, width, width, color);
+		}
+		return;
+	}
+
+	// half-width offsets across and along the segment
+	int ox = round_div(-dy * width, 2 * (int64_t)len);
+	int oy = round_div(dx * width, 2 * (int64_t)len);
+
+	if (cap == LINE_CAP_SQUARE) {
+		x0 -= oy; y0 += ox;
+		x1 += oy; y1 -= ox;
+	}
+
+	vec2d quad[4] = {
+		{x0 + ox, y0 + oy},
+		{x1 + ox, y1 + oy},
+		{x1 - ox, y1 - oy},
+		{x0 - ox, y0 - oy},
+	};
+	fill_polygon(ctx, quad, 4, color);
+
+	if (cap == LINE_CAP_ROUND) {
+		draw_solid_circle(ctx, x0, y0, r, color);
+		draw_solid_circle(ctx, x1, y1, r, color);
+	}
+}
+
+void draw_line_capped(GraphicsContext* ctx, int x0, int y0, int x1, int y1, int thickness, int cap, uint16_t color)
+{
+	int width = thickness < 1 ? 1 : thickness;
+	int margin = width + 1;
+
+	// trivial reject: the widened bounding box misses the context
+	if ((x0 < x1 ? x1 : x0) + margin < 0 || (x0 < x1 ? x0 : x1) - margin >= ctx->width ||
+	    (y0 < y1 ? y1 : y0) + margin < 0 || (y0 < y1 ? y0 : y1) - margin >= ctx->height) {
+		return;
+	}
+
+	mark_damage(ctx, (x0 < x1 ? x0 : x1) - margin, (y0 < y1 ? y0 : y1) - margin,
+	            (x0 < x1 ? x1 : x0) + margin + 1, (y0 < y1 ? y1 : y0) + margin + 1);
+
+	if (width == 1) {
+		draw_thin_line(ctx, x0, y0, x1, y1, color);
+	} else {
+		draw_thick_line(ctx, x0, y0, x1, y1, width, cap, color);
+	}
+}
+
+void draw_line(GraphicsContext* ctx, int x0, int y0, int x1, int y1, int thickness, uint16_t color)
+{
+	draw_line_capped(ctx, x0, y0, x1, y1, thickness, LINE_CAP_ROUND, color);
+}
+
+// Same pixels as draw_line over each segment, but every joint's round cap
+// is drawn once instead of twice.
+void draw_polyline(GraphicsContext* ctx, const vec2d* points, int count, int thickness, uint16_t color)
+{
+	int width = thickness < 1 ? 1 : thickness;
+	int margin = width + 1;
+	bool prev_drawn = false;
+
+	for (int i = 1; i < count; i++) {
+		int x0 = points[i - 1].x, y0 = points[i - 1].y;
+		int x1 = points[i].x, y1 = points[i].y;
+
+		if ((x0 < x1 ? x1 : x0) + margin < 0 || (x0 < x1 ? x0 : x1) - margin >= ctx->width ||
+		    (y0 < y1 ? y1 : y0) + margin < 0 || (y0 < y1 ? y0 : y1) - margin >= ctx->height) {
+			prev_drawn = false;
+			continue;
+		}
+
+		mark_damage(ctx, (x0 < x1 ? x0 : x1) - margin, (y0 < y1 ? y0 : y1) - margin,
+		            (x0 < x1 ? x1 : x0) + margin + 1, (y0 < y1 ? y1 : y0) + margin + 1);
+
+		if (width == 1) {
+			draw_thin_line(ctx, x0, y0, x1, y1, color);
+			continue;
+		}
+		draw_thick_line(ctx, x0, y0, x1, y1, width, LINE_CAP_BUTT, color);
+		if (!prev_drawn) {
+			draw_solid_circle(ctx, x0, y0, width / 2, color);
+		}
+		draw_solid_circle(ctx, x1, y1, width / 2, color);
+		prev_drawn = true;
+	}
+}
+
+void draw_hline(GraphicsContext* ctx, int x1, int x2, int y, uint16_t color)
+{
+	if (x1 > x2) {
+		int temp = x1;
+		x1 = x2;
+		x2 = temp;
+	}
+	mark_damage(ctx, x1, y, x2 + 1, y + 1);
+	fill_hspan(ctx, x1, x2, y, color);
+}
+
+void fill_rect(GraphicsContext* ctx, int x, int y, int w, int h, uint16_t color)
+{
+	int x0 = x < 0 ? 0 : x;
+	int y0 = y < 0 ? 0 : y;
+	int x1 = x + w > ctx->width ? ctx->width : x + w;
+	int y1 = y + h > ctx->height ? ctx->height : y + h;
+
+	if (x0 >= x1 || y0 >= y1) return;
+
+	mark_damage(ctx, x0, y0, x1, y1);
+	int row = y0 * ctx->width + x0;
+	if (x1 - x0 == ctx->width) {
+		// full-width band is one contiguous span
+		fill_pixels(ctx, row, ctx->width * (y1 - y0), color);
+		return;
+	}
+	for (int j = y0; j < y1; j++, row += ctx->width) {
+		fill_pixels(ctx, row, x1 - x0, color);
+	}
+}
+
+void draw_spans(GraphicsContext* ctx, const ColorSpan* spans, int count)
+{
+	if (count <= 0) return;
+
+	int min_x = spans[0].x, max_x = spans[0].x + spans[0].len;
+	int min_y = spans[0].y, max_y = spans[0].y + 1;
+	for (int i = 0; i < count; i++) {
+		const ColorSpan* sp = &spans[i];
+		fill_hspan(ctx, sp->x, sp->x + sp->len - 1, sp->y, sp->color);
+		if (sp->x < min_x) min_x = sp->x;
+		if (sp->x + sp->len > max_x) max_x = sp->x + sp->len;
+		if (sp->y < min_y) min_y = sp->y;
+		if (sp->y + 1 > max_y) max_y = sp->y + 1;
+	}
+	mark_damage(ctx, min_x, min_y, max_x, max_y);
+}
+
+void draw_polygon(GraphicsContext* ctx, const vec2d* vertices, int vertexCount, int thickness, uint16_t color)
+{
+	for (int i = 0; i < vertexCount; ++i) {
+		vec2d p1 = vertices[i];
+		vec2d p2 = vertices[(i + 1) % vertexCount];
+		draw_line(ctx, p1.x, p1.y, p2.x, p2.y, thickness, color);
+	}
+}
+
+// polygons up to this many vertices keep their edge table on the stack
+#define POLY_MAX_EDGES 64
+
+// Scanline edge of a polygon. The intersection with the current row is
+// kept exactly as x + num / den, so stepping it needs no floats.
+typedef struct {
+	int y_top;
+	int y_end;
+	int x;
+	int num;
+	int den;
+	int step_x;
+	int step_num;
+} PolyEdge;
+
+static int edge_is_left_of(const PolyEdge* a, const PolyEdge* b)
+{
+	if (a->x != b->x) return a->x < b->x;
+	return (int64_t)a->num * b->den < (int64_t)b->num * a->den;
+}
+
+// `edges`, `pending` and `active` hold vertexCount entries each
+static void fill_polygon_edges(GraphicsContext* ctx, const vec2d* vertices, int vertexCount, uint16_t color,
+	PolyEdge* edges, PolyEdge** pending, PolyEdge** active)
+{
+	int edge_count = 0;
+	int min_x = vertices[0].x, max_x = vertices[0].x;
+	int min_y = vertices[0].y, max_y = vertices[0].y;
+
+	// Build the edge table once, dropping horizontal edges and edges outside
+	// the context. Edges starting above the top row are advanced to it directly.
+	for (int i = 0; i < vertexCount; i++) {
+		vec2d a = vertices[i];
+		vec2d b = vertices[(i + 1) % vertexCount];
+
+		if (a.x < min_x) min_x = a.x;
+		if (a.x > max_x) max_x = a.x;
+		if (a.y < min_y) min_y = a.y;
+		if (a.y > max_y) max_y = a.y;
+
+		if (a.y == b.y) continue;
+		if (a.y > b.y) {
+			vec2d temp = a;
+			a = b;
+			b = temp;
+		}
+		if (b.y <= 0 || a.y >= ctx->height) continue;
+
+		PolyEdge* e = &edges[edge_count];
+		e->y_top = a.y < 0 ? 0 : a.y;
+		e->y_end = b.y;
+		e->den = b.y - a.y;
+		e->x = a.x + floor_div((int64_t)(e->y_top - a.y) * (b.x - a.x), e->den, &e->num);
+		e->step_x = floor_div(b.x - a.x, e->den, &e->step_num);
+
+		int j = edge_count++;
+		while (j > 0 && pending[j - 1]->y_top > e->y_top) {
+			pending[j] = pending[j - 1];
+			j--;
+		}
+		pending[j] = e;
+	}
+
+	if (edge_count > 0) {
+		mark_damage(ctx, min_x, min_y, max_x + 1, max_y + 1);
+	}
+
+	int next = 0;
+	int active_count = 0;
+	int y = 0;
+
+	while (next < edge_count || active_count > 0) {
+		if (active_count == 0 && pending[next]->y_top > y) {
+			y = pending[next]->y_top;
+		}
+		if (y >= ctx->height) break;
+
+		int kept = 0;
+		for (int i = 0; i < active_count; i++) {
+			if (active[i]->y_end > y) {
+				active[kept++] = active[i];
+			}
+		}
+		active_count = kept;
+
+		while (next < edge_count && pending[next]->y_top == y) {
+			PolyEdge* e = pending[next++];
+			int j = active_count++;
+			while (j > 0 && edge_is_left_of(e, active[j - 1])) {
+				active[j] = active[j - 1];
+				j--;
+			}
+			active[j] = e;
+		}
+
+		int row = y * ctx->width;
+		for (int i = 0; i + 1 < active_count; i += 2) {
+			int x0 = active[i]->x + (active[i]->num != 0); // ceil
+			int x1 = active[i + 1]->x;                      // floor
+			if (x0 > x1) {
+				// sliver narrower than a pixel, covered like draw_hline(x0, x1)
+				int temp = x0;
+				x0 = x1;
+				x1 = temp;
+			}
+			if (x0 < 0) x0 = 0;
+			if (x1 >= ctx->width) x1 = ctx->width - 1;
+			if (x0 <= x1) {
+				fill_pixels(ctx, row + x0, x1 - x0 + 1, color);
+			}
+		}
+
+		for (int i = 0; i < active_count; i++) {
+			PolyEdge* e = active[i];
+			e->x += e->step_x;
+			e->num += e->step_num;
+			if (e->num >= e->den) {
+				e->num -= e->den;
+				e->x++;
+			}
+		}
+
+		// Active edges only swap places where the polygon self-intersects,
+		// so this pass is linear for ordinary polygons.
+		for (int i = 1; i < active_count; i++) {
+			PolyEdge* e = active[i];
+			int j = i;
+			while (j > 0 && edge_is_left_of(e, active[j - 1])) {
+				active[j] = active[j - 1];
+				j--;
+			}
+			active[j] = e;
+		}
+
+		y++;
+	}
+}
+
+void fill_polygon(GraphicsContext* ctx, const vec2d* vertices, int vertexCount, uint16_t color)
+{
+	if (vertexCount == 0) return;
+
+	if (vertexCount <= POLY_MAX_EDGES) {
+		PolyEdge edges[POLY_MAX_EDGES];
+		PolyEdge* pending[POLY_MAX_EDGES];
+		PolyEdge* active[POLY_MAX_EDGES];
+		fill_polygon_edges(ctx, vertices, vertexCount, color, edges, pending, active);
+		return;
+	}
+
+	// rare enough that a heap table per call is fine, the draw bands may
+	// fill polygons at the same time so there is no shared one
+	PolyEdge** pending = malloc(vertexCount * (2 * sizeof(PolyEdge*) + sizeof(PolyEdge)));
+	if (!pending) {
+		ctx->failures++;
+		return;
+	}
+	PolyEdge** active = pending + vertexCount;
+	fill_polygon_edges(ctx, vertices, vertexCount, color, (PolyEdge*)(active + vertexCount), pending, active);
+	free(pending);
+}
+
+#define FILL_MAX_RUNS 32
+
+// Row y of the columns in [first, last): runs of columns whose top is at
+// or above the row. Returns the run count, or -1 if there are more than
+// `max` runs (nothing is drawn then).
+static int column_runs(int x, const int16_t* tops, int first, int last, int y, int runs[][2], int max)
+{
+	int count = 0;
+	for (int i = first; i < last; ) {
+		while (i < last && tops[i] > y) i++;
+		int start = i;
+		while (i < last && tops[i] <= y) i++;
+		if (i > start) {
+			if (count == max) return -1;
+			runs[count][0] = x + start;
+			runs[count++][1] = i - start;
+		}
+	}
+	return count;
+}
+
+// Walked by rows, so the span kernel gets contiguous runs and every pixel
+// is written once. Below the lowest top the runs stop changing; they are
+// found once and repeated down to the bottom.
+void fill_columns(GraphicsContext* ctx, int x, const int16_t* tops, int count, uint16_t color)
+{
+	int first = x < 0 ? -x : 0;
+	int last = x + count > ctx->width ? ctx->width - x : count;
+	int min_top = ctx->height, max_top = 0;
+	for (int i = first; i < last; i++) {
+		int top = tops[i] < 0 ? 0 : tops[i];
+		if (top >= ctx->height) continue;
+		if (top < min_top) min_top = top;
+		if (top > max_top) max_top = top;
+	}
+	if (min_top >= ctx->height) return;
+
+	mark_damage(ctx, x + first, min_top, x + last, ctx->height);
+
+	int runs[FILL_MAX_RUNS][2];
+	int run_count = -1;
+	for (int y = min_top; y < ctx->height; y++) {
+		if (y <= max_top || run_count < 0) {
+			run_count = column_runs(x, tops, first, last, y, runs, FILL_MAX_RUNS);
+		}
+		if (run_count < 0) {
+			// too fragmented to keep, fill this row run by run as found
+			for (int i = first; i < last; ) {
+				while (i < last && tops[i] > y) i++;
+				int start = i;
+				while (i < last && tops[i] <= y) i++;
+				if (i > start) fill_pixels(ctx, y * ctx->width + x + start, i - start, color);
+			}
+			continue;
+		}
+		if (y >= max_top && run_count == 1 && runs[0][1] == ctx->width) {
+			fill_pixels(ctx, y * ctx->width, ctx->width * (ctx->height - y), color);
+			return;
+		}
+		for (int r = 0; r < run_count; r++) {
+			fill_pixels(ctx, y * ctx->width + runs[r][0], runs[r][1], color);
+		}
+	}
+}
+
+void circle_draw_8_points(GraphicsContext* ctx, int xc, int yc, int x, int y, uint16_t color)
+{
+	plot(ctx, xc+x, yc+y, color);
+	plot(ctx, xc-x, yc+y, color);
+	plot(ctx, xc+x, yc-y, color);
+	plot(ctx, xc-x, yc-y, color);
+	plot(ctx, xc+y, yc+x, color);
+	plot(ctx, xc-y, yc+x, color);
+	plot(ctx, xc+y, yc-x, color);
+	plot(ctx, xc-y, yc-x, color);
+}
+
+void draw_circle(GraphicsContext* ctx, int center_x, int center_y, int radius, int thickness, uint16_t color)
+{
+	(void)thickness;
+
+	// the midpoint walk overshoots by a pixel for tiny radii
+	mark_damage(ctx, center_x - radius - 1, center_y - radius - 1, center_x + radius + 2, center_y + radius + 2);
+
+	int x = 0, y = radius;
+	int d = 3 - 2 * radius;
+	circle_draw_8_points(ctx, center_x, center_y, x, y, color);
+	while (y >= x) {
+		if (d > 0) {
+			d = d + 4 * (x - y) + 10;
+			y--;
+		}
+		else {
+			d = d + 4 * x + 6;
+		}
+		x++;
+		circle_draw_8_points(ctx, center_x, center_y, x, y, color);
+	}
+}
+
+void draw_solid_circle(GraphicsContext* ctx, int center_x, int center_y, int radius, uint16_t color)
+{
+	if (center_x + radius < 0 || center_x - radius >= ctx->width ||
+	    center_y + radius < 0 || center_y - radius >= ctx->height) {
+		return;
+	}
+
+	mark_damage(ctx, center_x - radius, center_y - radius, center_x + radius + 1, center_y + radius + 1);
+
+	int x = 0, y = radius;
+	int d = 3 - 2 * radius;
+
+	while (y >= x) {
+		fill_hspan(ctx, center_x - y, center_x + y, center_y + x, color);
+		if (x != 0) {
+			fill_hspan(ctx, center_x - y, center_x + y, center_y - x, color);
+		}
+
+		// rows at +-y only grow while y stays, so emit just the widest one
+		if (d > 0 || y < x + 1) {
+			fill_hspan(ctx, center_x - x, center_x + x, center_y + y, color);
+			fill_hspan(ctx, center_x - x, center_x + x, center_y - y, color);
+		}
+
+		if (d > 0) {
+			d = d + 4 * (x - y) + 10;
+			y--;
+		}
+		else {
+			d = d + 4 * x + 6;
+		}
+		x++;
+	}
+}
+
+void draw_text(GraphicsContext* ctx, const char* text, int x, int y, uint16_t color, int anchor) {
+	if (!text) {
+		return;
+	}
+
+	int text_width = strlen(text) * FONT_W;
+	int text_height = FONT_H;
+
+	if (anchor & ANCHOR_HCENTER) {
+		x -= text_width / 2;
+	} else if (anchor & ANCHOR_RIGHT) {
+		x -= text_width;
+	}
+
+	if (anchor & ANCHOR_VCENTER) {
+		y -= text_height / 2;
+	} else if (anchor & ANCHOR_BOTTOM) {
+		y -= text_height;
+	}
+
+	if (y < -text_height || y > ctx->height || x < -text_width || x > ctx->width) {
+		return;
+	}
+
+	mark_damage(ctx, x, y, x + text_width, y + text_height);
+
+	const char* str = text;
+	int current_x = x;
+
+	while (*str) {
+		char c = *str;
+
+		if (current_x >= ctx->width || current_x < -FONT_W) {
+			str++;
+			current_x += FONT_W;
+			continue;
+		}
+
+		if ((unsigned char)c < 0x20 || (unsigned char)c > 0x7F) {
+			c = '?';
+		}
+
+		const uint8_t* glyph = font_data + (c - 0x20) * FONT_H;
+
+		for (int row = 0; row < FONT_H; ++row) {
+			int pixel_y = y + row;
+
+			if (pixel_y < 0 || pixel_y >= ctx->height) {
+				continue;
+			}
+
+			uint8_t row_data = glyph[row];
+
+			for (int col = 0; col < FONT_W; ++col, row_data <<= 1) {
+				if (row_data & 0x80) {
+					int pixel_x = current_x + col;
+					if (pixel_x >= 0 && pixel_x < ctx->width) {
+						put_pixel(ctx, pixel_y * ctx->width + pixel_x, color);
+					}
+				}
+			}
+		}
+
+		str++;
+		current_x += FONT_W;
+	}
+}
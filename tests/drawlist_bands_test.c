@@ -0,0 +1,96 @@
+// Rasterizes the same draw list serially and band by band, the way the
+// desktop band workers split a frame, and requires the same pixels. The
+// list holds polygons and outlines well past 64 vertices.
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "drawlist.h"
+
+#define W 96
+#define H 80
+
+static DrawList list;
+static uint16_t serial[W * H];
+static uint16_t banded[W * H];
+static vec2d scratch[DL_MAX_VERTICES];
+
+// star of `count` vertices alternating between two radii
+static void star(vec2d* out, int count, int cx, int cy, int r0, int r1)
+{
+	for (int i = 0; i < count; i++) {
+		int r = i & 1 ? r1 : r0;
+		double angle = i * 2 * M_PI / count;
+		out[i] = (vec2d){cx + (int)lround(r * cos(angle)), cy + (int)lround(r * sin(angle))};
+	}
+}
+
+static void build_list(void)
+{
+	static vec2d points[DL_MAX_VERTICES];
+
+	drawlist_begin(&list, NULL);
+	drawlist_set_layer(&list, DL_LAYER_GROUND);
+	star(points, 300, 40, 40, 38, 20);
+	dl_polygon(&list, points, 300, 0x07e0);
+	star(points, 130, 70, 30, 25, 12);
+	dl_polygon_outline(&list, points, 130, 2, 0xffff);
+	drawlist_set_layer(&list, DL_LAYER_BODIES);
+	star(points, 8, 20, 60, 12, 6);
+	dl_polygon(&list, points, 8, 0xf800);
+	dl_solid_circle(&list, 60, 55, 9, 0x001f);
+	dl_line(&list, 0, 79, 95, 0, 1, 0xffe0);
+	dl_rect(&list, 5, 5, 20, 9, 0xf81f);
+}
+
+static void init_context(GraphicsContext* ctx, uint16_t* framebuf)
+{
+	memset(ctx, 0, sizeof(*ctx));
+	memset(framebuf, 0, W * H * sizeof(uint16_t));
+	ctx->framebuf = framebuf;
+	ctx->width = W;
+	ctx->height = H;
+}
+
+// renders `list` into `banded` in bands of `band_height` rows
+static void render_bands(int band_height)
+{
+	drawlist_sort(&list);
+	for (int y0 = 0; y0 < H; y0 += band_height) {
+		GraphicsContext sub = {0};
+		sub.framebuf = banded + y0 * W;
+		sub.width = W;
+		sub.height = y0 + band_height < H ? band_height : H - y0;
+		drawlist_execute_band(&list, &sub, y0, scratch);
+	}
+}
+
+int main(void)
+{
+	static const int band_heights[] = {16, 7, 1, H};
+	GraphicsContext ctx;
+	int failures = 0;
+
+	build_list();
+	init_context(&ctx, serial);
+	drawlist_execute_serial(&list, &ctx);
+
+	for (unsigned i = 0; i < sizeof(band_heights) / sizeof(band_heights[0]); i++) {
+		init_context(&ctx, banded);
+		render_bands(band_heights[i]);
+		int diff = 0;
+		for (int p = 0; p < W * H; p++) {
+			diff += serial[p] != banded[p];
+		}
+		if (diff) {
+			printf("drawlist bands: %d rows per band, %d pixels differ\n", band_heights[i], diff);
+			failures++;
+		}
+	}
+
+	if (failures) {
+		return 1;
+	}
+	printf("drawlist bands: ok\n");
+	return 0;
+}
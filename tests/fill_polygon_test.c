@@ -0,0 +1,199 @@
+// Rasterizes convex, concave and self-intersecting polygons with
+// fill_polygon and with the float scanline filler it replaced, and
+// requires the same pixels from both.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "graphics.h"
+
+#define W 96
+#define H 80
+#define MAX_VERTICES 300
+
+static uint16_t expected[W * H];
+static uint16_t actual[W * H];
+static uint32_t rng_state = 12345;
+
+static int rand_range(int lo, int hi)
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return lo + (int)(rng_state % (uint32_t)(hi - lo + 1));
+}
+
+static void reference_pixel(int x, int y, uint16_t color)
+{
+	if (x >= 0 && x < W && y >= 0 && y < H) {
+		expected[y * W + x] = color;
+	}
+}
+
+// the filler fill_polygon replaced, as it was
+static void reference_fill(const vec2d* vertices, int vertexCount, uint16_t color)
+{
+	if (vertexCount == 0) return;
+
+	float min_y = vertices[0].y;
+	float max_y = vertices[0].y;
+	for (int i = 1; i < vertexCount; i++) {
+		if (vertices[i].y < min_y) min_y = vertices[i].y;
+		if (vertices[i].y > max_y) max_y = vertices[i].y;
+	}
+
+	for (int y = (int)ceilf(min_y); y <= (int)floorf(max_y); y++) {
+		float intersections[vertexCount];
+		int intersection_count = 0;
+
+		for (int i = 0; i < vertexCount; i++) {
+			vec2d p1 = vertices[i];
+			vec2d p2 = vertices[(i + 1) % vertexCount];
+
+			if (p1.y == p2.y) continue;
+
+			if (y >= fminf(p1.y, p2.y) && y < fmaxf(p1.y, p2.y)) {
+				float x = p1.x + (y - p1.y) * (p2.x - p1.x) / (float)(p2.y - p1.y);
+				intersections[intersection_count++] = x;
+			}
+		}
+
+		for (int i = 0; i < intersection_count - 1; i++) {
+			for (int j = 0; j < intersection_count - i - 1; j++) {
+				if (intersections[j] > intersections[j + 1]) {
+					float temp = intersections[j];
+					intersections[j] = intersections[j + 1];
+					intersections[j + 1] = temp;
+				}
+			}
+		}
+
+		for (int i = 0; i + 1 < intersection_count; i += 2) {
+			int x1 = (int)ceilf(intersections[i]), x2 = (int)floorf(intersections[i + 1]);
+			if (x1 > x2) {
+				int temp = x1;
+				x1 = x2;
+				x2 = temp;
+			}
+			for (int x = x1; x <= x2; x++) {
+				reference_pixel(x, y, color);
+			}
+		}
+	}
+}
+
+// returns the number of differing pixels
+static int compare(const char* name, const vec2d* vertices, int count)
+{
+	GraphicsContext ctx = {0};
+	ctx.framebuf = actual;
+	ctx.width = W;
+	ctx.height = H;
+	memset(expected, 0, sizeof(expected));
+	memset(actual, 0, sizeof(actual));
+
+	reference_fill(vertices, count, 0xffff);
+	fill_polygon(&ctx, vertices, count, 0xffff);
+
+	int bad = 0;
+	for (int i = 0; i < W * H; i++) {
+		if (expected[i] != actual[i]) {
+			if (bad == 0) {
+				printf("%s, %d vertices: first difference at (%d, %d)\n", name, count, i % W, i / W);
+			}
+			bad++;
+		}
+	}
+	return bad;
+}
+
+// vertices around (cx, cy) at increasing angles, so the polygon is simple;
+// equal radii make it convex
+static int star(vec2d* v, int count, int cx, int cy, int r_min, int r_max)
+{
+	double angles[MAX_VERTICES];
+	for (int i = 0; i < count; i++) {
+		angles[i] = rand_range(0, 35999) / 18000.0 * M_PI;
+	}
+	for (int i = 1; i < count; i++) {
+		for (int j = i; j > 0 && angles[j - 1] > angles[j]; j--) {
+			double t = angles[j];
+			angles[j] = angles[j - 1];
+			angles[j - 1] = t;
+		}
+	}
+	for (int i = 0; i < count; i++) {
+		int r = rand_range(r_min, r_max);
+		v[i].x = cx + (int)lround(r * cos(angles[i]));
+		v[i].y = cy + (int)lround(r * sin(angles[i]));
+	}
+	return count;
+}
+
+int main(void)
+{
+	static const vec2d triangle[] = {{10, 5}, {60, 20}, {25, 70}};
+	static const vec2d sliver[] = {{5, 5}, {90, 6}, {5, 7}};
+	static const vec2d l_shape[] = {{10, 10}, {40, 10}, {40, 30}, {25, 30}, {25, 60}, {10, 60}};
+	static const vec2d bowtie[] = {{10, 10}, {80, 70}, {80, 10}, {10, 70}};
+	static const vec2d clipped[] = {{-30, -20}, {130, 10}, {50, 120}, {-10, 60}};
+	static const vec2d outside[] = {{-30, -20}, {-5, -20}, {-5, -2}};
+	static const vec2d collinear[] = {{10, 10}, {20, 20}, {30, 30}};
+	static const vec2d tall[] = {{40, -500}, {41, 500}, {39, 500}};
+	static const struct {
+		const char* name;
+		const vec2d* v;
+		int count;
+	} fixed[] = {
+		{"triangle", triangle, 3},
+		{"sliver", sliver, 3},
+		{"l shape", l_shape, 6},
+		{"bowtie", bowtie, 4},
+		{"clipped", clipped, 4},
+		{"outside", outside, 3},
+		{"collinear", collinear, 3},
+		{"tall", tall, 3},
+	};
+
+	int failed = 0, polygons = 0;
+	for (unsigned i = 0; i < sizeof(fixed) / sizeof(fixed[0]); i++, polygons++) {
+		if (compare(fixed[i].name, fixed[i].v, fixed[i].count)) failed++;
+	}
+
+	vec2d v[MAX_VERTICES];
+	for (int i = 0; i < 2000; i++, polygons++) {
+		int count = rand_range(3, 40);
+		int r = rand_range(3, 60);
+		int cx = rand_range(-20, W + 20), cy = rand_range(-20, H + 20);
+		const char* name;
+		if (i % 4 == 0) {
+			name = "convex";
+			star(v, count, cx, cy, r, r);
+		} else if (i % 4 == 3) {
+			// any order, self-intersecting
+			name = "random";
+			for (int k = 0; k < count; k++) {
+				v[k].x = rand_range(-20, W + 20);
+				v[k].y = rand_range(-20, H + 20);
+			}
+		} else {
+			name = "concave";
+			star(v, count, cx, cy, r / 3, r);
+		}
+		if (compare(name, v, count)) failed++;
+	}
+
+	// past the stack edge table
+	for (int count = 60; count <= MAX_VERTICES; count += 40, polygons++) {
+		star(v, count, W / 2, H / 2, 10, 45);
+		if (compare("large", v, count)) failed++;
+	}
+
+	if (failed) {
+		printf("fill_polygon: %d of %d polygons differ\n", failed, polygons);
+		return 1;
+	}
+	printf("fill_polygon: %d polygons match\n", polygons);
+	return 0;
+}
@@ -0,0 +1,92 @@
+// Checks the table trig in fixmath.c against libm, and the integer
+// helpers against exact results.
+
+#include <stdio.h>
+#include <math.h>
+#include "fixmath.h"
+
+#define SIN_MAX_ERROR 1e-5
+// atan2 rounds to whole degrees, the half degree is the rounding itself
+// and the rest the tangent bounds being Q16.16
+#define ATAN2_MAX_ERROR 0.51
+
+static double degrees_apart(double a, double b)
+{
+	double d = fmod(fabs(a - b), 360.0);
+	return d > 180.0 ? 360.0 - d : d;
+}
+
+int main(void)
+{
+	int failures = 0;
+
+	double sin_error = 0, cos_error = 0;
+	for (int deg = -720; deg < 720; deg++) {
+		double rad = deg * M_PI / 180.0;
+		double s = fabs(fix_sin_deg(deg) / (double)FIX16_ONE - sin(rad));
+		double c = fabs(fix_cos_deg(deg) / (double)FIX16_ONE - cos(rad));
+		if (s > sin_error) sin_error = s;
+		if (c > cos_error) cos_error = c;
+	}
+	printf("sin: max error %.2e, cos: max error %.2e\n", sin_error, cos_error);
+	if (sin_error > SIN_MAX_ERROR || cos_error > SIN_MAX_ERROR) failures++;
+
+	// a grid of vectors, plus unit vectors in Q16.16 like the car passes
+	double atan2_error = 0;
+	int worst_x = 0, worst_y = 0;
+	for (int y = -1000; y <= 1000; y += 7) {
+		for (int x = -1000; x <= 1000; x += 7) {
+			double e = degrees_apart(fix_atan2_deg(y, x), atan2(y, x) * 180.0 / M_PI);
+			if (e > atan2_error) {
+				atan2_error = e;
+				worst_x = x;
+				worst_y = y;
+			}
+		}
+	}
+	for (int i = 0; i < 3600; i++) {
+		double rad = i * M_PI / 1800.0;
+		int x = (int)lround(cos(rad) * FIX16_ONE), y = (int)lround(sin(rad) * FIX16_ONE);
+		int deg = fix_atan2_deg(y, x);
+		double e = degrees_apart(deg, i / 10.0);
+		if (deg < 0 || deg >= 360) e = 360;
+		if (e > atan2_error) {
+			atan2_error = e;
+			worst_x = x;
+			worst_y = y;
+		}
+	}
+	printf("atan2: max error %.3f degrees at (%d, %d)\n", atan2_error, worst_x, worst_y);
+	if (atan2_error > ATAN2_MAX_ERROR) failures++;
+
+	for (uint64_t v = 0; v < 2000000; v++) {
+		uint64_t r = isqrt64(v);
+		if (r * r > v || (r + 1) * (r + 1) <= v) {
+			printf("isqrt64(%llu) = %llu\n", (unsigned long long)v, (unsigned long long)r);
+			failures++;
+			break;
+		}
+	}
+	uint64_t big = 0xfffffffe00000001ull; // (2^32 - 1)^2
+	if (isqrt64(big) != 0xffffffffu || isqrt64(big - 1) != 0xfffffffeu) {
+		printf("isqrt64 wrong near 2^64\n");
+		failures++;
+	}
+
+	for (int d = 1; d <= 64; d++) {
+		for (int n = -1000; n <= 1000; n++) {
+			int expected = (int)lround((double)n / d);
+			if (div_round(n, d) != expected) {
+				printf("div_round(%d, %d) = %d, expected %d\n", n, d, div_round(n, d), expected);
+				failures++;
+			}
+		}
+	}
+
+	if (failures) {
+		printf("fixmath: %d failure(s)\n", failures);
+		return 1;
+	}
+	printf("fixmath: ok\n");
+	return 0;
+}
@@ -0,0 +1,30 @@
+#!/bin/sh
+# Draws the test scene of the headless runner and compares the dumped
+# frames against the references in tests/golden, with one and two
+# buffers, RGB565 and indexed. All of them must match the same images.
+# With --update the references are redrawn instead.
+#
+#   tests/golden.sh build/app-headless [--update]
+
+app=${1:-build/app-headless}
+golden=$(dirname "$0")/golden
+scene="--scene --seed 5 --size 128x96 --dt 33 --frames 48 --dump 0,1,20,47"
+
+if [ "$2" = "--update" ]; then
+	mkdir -p "$golden"
+	"$app" $scene --out "$golden" > /dev/null || exit 1
+	echo "golden: references redrawn"
+	exit 0
+fi
+
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+
+for variant in "--buffers 1" "--buffers 2" "--buffers 1 --indexed" "--buffers 2 --indexed"; do
+	"$app" $scene $variant --out "$dir" --golden "$golden" --tolerance 0 --max-bad 0 > "$dir/run.log" || {
+		cat "$dir/run.log"
+		echo "golden: $variant differs from tests/golden"
+		exit 1
+	}
+done
+echo "golden: ok"
@@ -0,0 +1,114 @@
+// Draws a moving scene with damage tracking, single and double buffered,
+// and pushes every frame through refresh_display to a simulated LCD. The
+// LCD must always match a full redraw, frames kept as is must push
+// nothing, and the band pushed must stay well below whole frames.
+
+#include <stdio.h>
+#include <string.h>
+#include "graphics.h"
+
+#define W 96
+#define H 80
+#define FRAMES 240
+
+static uint16_t lcd[W * H];
+static uint16_t expected[W * H];
+static uint16_t buffers[2][W * H];
+static long pushed_pixels;
+
+static void stub_push(GraphicsContext* ctx, int y0, int y1)
+{
+	memcpy(lcd + y0 * W, ctx->framebuf + y0 * W, (y1 - y0) * W * sizeof(uint16_t));
+	pushed_pixels += (long)(y1 - y0) * W;
+}
+
+// a status bar that never changes and a box that moves every third frame,
+// jumping between rows so each buffer's band differs from the other's
+static int box_pos(int frame)
+{
+	return (frame / 3) % 31;
+}
+
+static void draw_scene(GraphicsContext* ctx, int frame)
+{
+	int pos = box_pos(frame);
+	fill_rect(ctx, 0, H - 10, W, 6, 0xffff);
+	fill_rect(ctx, pos * 2, 8 + pos * 7 % 50, 12, 10, 0xf800);
+}
+
+static int run(int buffer_count)
+{
+	GraphicsContext frames[2];
+	memset(frames, 0, sizeof(frames));
+	for (int i = 0; i < buffer_count; i++) {
+		GraphicsContext* ctx = &frames[i];
+		ctx->framebuf = buffers[i];
+		ctx->width = W;
+		ctx->height = H;
+		ctx->track_damage = true;
+		damage_reset(ctx);
+	}
+	GraphicsContext* front = &frames[0];
+	GraphicsContext* back = &frames[buffer_count - 1];
+
+	GraphicsContext full = {0};
+	full.framebuf = expected;
+	full.width = W;
+	full.height = H;
+
+	for (int i = 0; i < W * H; i++) {
+		lcd[i] = 0x1234;
+	}
+	pushed_pixels = 0;
+
+	int failures = 0;
+	int drawn = 0;
+	for (int frame = 0; frame < FRAMES; frame++) {
+		bool same = frame > 0 && box_pos(frame) == box_pos(frame - 1);
+		long before = pushed_pixels;
+		if (same) {
+			keep_frame(back);
+		} else {
+			begin_frame(back);
+			draw_scene(back, frame);
+			drawn = frame;
+		}
+
+		if (refresh_display(back, front, stub_push) > 0) {
+			GraphicsContext* shown = back;
+			back = front;
+			front = shown;
+		}
+
+		begin_frame(&full);
+		draw_scene(&full, drawn);
+		if (memcmp(lcd, expected, sizeof(lcd))) {
+			printf("%d buffers, frame %d: LCD doesn't match the scene\n", buffer_count, frame);
+			failures++;
+		}
+		if (same && pushed_pixels != before) {
+			printf("%d buffers, frame %d: pushed %ld pixels for a kept frame\n",
+				buffer_count, frame, pushed_pixels - before);
+			failures++;
+		}
+	}
+
+	long whole = (long)FRAMES * W * H;
+	printf("%d buffers: pushed %ld of %ld pixels\n", buffer_count, pushed_pixels, whole);
+	if (pushed_pixels * 2 > whole) {
+		printf("%d buffers: pushed more than half of the frames\n", buffer_count);
+		failures++;
+	}
+	return failures;
+}
+
+int main(void)
+{
+	int failures = run(1) + run(2);
+	if (failures) {
+		printf("refresh: %d failures\n", failures);
+		return 1;
+	}
+	printf("refresh: ok\n");
+	return 0;
+}
@@ -0,0 +1,24 @@
+#!/bin/sh
+# Records a headless run with a restart in it, plays the recording back
+# and checks that every dumped frame matches exactly.
+#
+#   tests/replay.sh build/app-headless
+
+app=${1:-build/app-headless}
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+mkdir -p "$dir/record" "$dir/play"
+
+"$app" --frames 900 --gas --seed 7 --restart 300 --record "$dir/run.rec" \
+	--dump-every 50 --out "$dir/record" > "$dir/record.log" || {
+	cat "$dir/record.log"
+	echo "replay: recording failed"
+	exit 1
+}
+"$app" --frames 900 --play "$dir/run.rec" \
+	--dump-every 50 --out "$dir/play" --golden "$dir/record" --tolerance 0 --max-bad 0 > "$dir/play.log" || {
+	cat "$dir/play.log"
+	echo "replay: playback differs from the recording"
+	exit 1
+}
+echo "replay: ok"